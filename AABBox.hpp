@@ -6,10 +6,6 @@
 #include "Ray.hpp"
 #include "simd/simd.h"
 
-#include "bigfloat.h"
-
-#include "TestConfig.hpp"
-
 #ifndef INFINITY
 #define INFINITY 1e8
 #endif
@@ -129,26 +125,6 @@ class AABBox
 		tfar.condAssign(tzfar < tfar, tzfar, tfar);
 	}
 
-#ifdef BIGFLOAT_SURFACE_COMPUTATION
-	BigFloat surfaceAreaPrecise() const
-	{
-		vec extend = max - min;
-		return BigFloat(2.0)*
-				((BigFloat(extend.x)*BigFloat(extend.y)) +
-				(BigFloat(extend.y)*BigFloat(extend.z)) +
-				(BigFloat(extend.z)*BigFloat(extend.x)));
-	}
-#else
-	long double surfaceAreaPrecise() const
-	{
-		vec extend = max - min;
-		return (long double)(2.0)*
-				(((long double)(extend.x)*(long double)(extend.y)) +
-				((long double)(extend.y)*(long double)(extend.z)) +
-				((long double)(extend.z)*(long double)(extend.x)));
-	}
-#endif
-	
 	float surfaceArea() const
 	{
 		vec extend = max - min;
@@ -0,0 +1,246 @@
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "BenchmarkBaseline.hpp"
+
+/// values of one JSON object. nested keys are joined with ".", e.g. "frameTime.median". arrays, null and booleans are skipped.
+struct FlatObject
+{
+	std::map<std::string, std::string> strings;
+	std::map<std::string, double> numbers;
+};
+
+/// reader of the JSON written by writeBenchmarkResults: an array of objects
+class JSONReader
+{
+public:
+	JSONReader(const std::string& text) : text(text), pos(0) {}
+
+	bool readArray(std::vector<FlatObject>& objects)
+	{
+		skipSpace();
+		if(!consume('[')) return false;
+		skipSpace();
+		if(consume(']')) return true;
+		do
+		{
+			skipSpace();
+			if(peek() != '{') return false;
+			objects.push_back(FlatObject());
+			if(!readValue("", &objects.back())) return false;
+			skipSpace();
+		} while(consume(','));
+		return consume(']');
+	}
+
+private:
+	const std::string& text;
+	size_t pos;
+
+	char peek() const { return pos < text.size() ? text[pos] : 0; }
+
+	bool consume(char c)
+	{
+		if(peek() != c) return false;
+		++pos;
+		return true;
+	}
+
+	void skipSpace()
+	{
+		while(pos < text.size() && isspace((unsigned char)text[pos])) ++pos;
+	}
+
+	bool readString(std::string& out)
+	{
+		if(!consume('"')) return false;
+		out.clear();
+		while(pos < text.size() && text[pos] != '"')
+		{
+			if(text[pos] == '\\' && pos+1 < text.size()) ++pos;
+			out += text[pos++];
+		}
+		return consume('"');
+	}
+
+	/// reads the value of the key path into object. the values are skipped if object is NULL.
+	bool readValue(const std::string& path, FlatObject* object)
+	{
+		skipSpace();
+		char c = peek();
+		if(c == '{')
+		{
+			++pos;
+			skipSpace();
+			if(consume('}')) return true;
+			do
+			{
+				skipSpace();
+				std::string key;
+				if(!readString(key)) return false;
+				skipSpace();
+				if(!consume(':')) return false;
+				if(!readValue(path.empty() ? key : path + "." + key, object)) return false;
+				skipSpace();
+			} while(consume(','));
+			return consume('}');
+		}
+		if(c == '[')
+		{
+			// the frame times. the comparison uses the statistics.
+			++pos;
+			skipSpace();
+			if(consume(']')) return true;
+			do
+			{
+				if(!readValue(path, NULL)) return false;
+				skipSpace();
+			} while(consume(','));
+			return consume(']');
+		}
+		if(c == '"')
+		{
+			std::string value;
+			if(!readString(value)) return false;
+			if(object) object->strings[path] = value;
+			return true;
+		}
+
+		// number or literal
+		size_t start = pos;
+		while(pos < text.size() && !strchr(",}] \t\r\n", text[pos])) ++pos;
+		std::string token = text.substr(start, pos - start);
+		if(token.empty()) return false;
+		if(token == "null" || token == "true" || token == "false") return true;
+
+		char* end;
+		double value = strtod(token.c_str(), &end);
+		if(*end) return false;
+		if(object) object->numbers[path] = value;
+		return true;
+	}
+};
+
+static double getNumber(const FlatObject& object, const std::string& key, double fallback)
+{
+	std::map<std::string, double>::const_iterator i = object.numbers.find(key);
+	return i != object.numbers.end() ? i->second : fallback;
+}
+
+static std::string getString(const FlatObject& object, const std::string& key)
+{
+	std::map<std::string, std::string>::const_iterator i = object.strings.find(key);
+	return i != object.strings.end() ? i->second : std::string();
+}
+
+static std::string makeConfiguration(const std::string& model, const std::string& method, const std::string& camera, int width, int height, int threads)
+{
+	std::ostringstream stream;
+	stream << model << " " << method << " " << camera << " " << width << "x" << height << " threads: " << threads;
+	return stream.str();
+}
+
+bool BenchmarkBaseline::load(const char* fileName)
+{
+	std::ifstream file(fileName);
+	if(file.fail()) return false;
+	std::stringstream content;
+	content << file.rdbuf();
+	std::string text = content.str();
+
+	std::vector<FlatObject> objects;
+	JSONReader reader(text);
+	if(!reader.readArray(objects)) return false;
+
+	entries.clear();
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const FlatObject& object = objects[i];
+		Entry entry;
+
+		entry.metrics[FRAME_TIME] = getNumber(object, "frames", 0.0) > 0.0 ? getNumber(object, "frameTime.median", -1.0) : -1.0;
+		entry.metrics[TRAVERSAL_TIME] = 0.0;
+		for (int stage = 0; stage < StageTimer::STAGE_COUNT; ++stage)
+		{
+			if(StageTimer::isTraversal(stage)) entry.metrics[TRAVERSAL_TIME] += getNumber(object, std::string("stageTimes.") + StageTimer::getStageName(stage), 0.0);
+		}
+		entry.metrics[CONSTRUCTION_TIME] = getNumber(object, "constructionTime", -1.0);
+		entry.metrics[NODE_MEMORY] = getNumber(object, "memory.nodes", -1.0);
+
+		std::string configuration = makeConfiguration(getString(object, "model"), getString(object, "method"), getString(object, "camera"),
+			(int)getNumber(object, "width", 0), (int)getNumber(object, "height", 0), (int)getNumber(object, "threads", 0));
+		entries[configuration] = entry;
+	}
+	return true;
+}
+
+int BenchmarkBaseline::compare(const std::vector<BenchmarkResult>& results, double tolerance, std::ostream& stream) const
+{
+	int regressions = 0;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		std::string configuration = getConfiguration(results[i]);
+		stream << configuration << "\n";
+
+		std::map<std::string, Entry>::const_iterator baseline = entries.find(configuration);
+		if(baseline == entries.end())
+		{
+			stream << "  not in the baseline\n";
+			continue;
+		}
+
+		double metrics[METRIC_COUNT];
+		getMetrics(results[i], metrics);
+		for (int m = 0; m < METRIC_COUNT; ++m)
+		{
+			double before = baseline->second.metrics[m];
+			double after = metrics[m];
+			if(before < 0.0 || after < 0.0) continue;
+
+			stream << "  " << getMetricName(m) << ": " << before << " -> " << after;
+			if(before > 0.0) stream << " (" << (after > before ? "+" : "") << 100.0 * (after - before) / before << "%)";
+
+			// times need an absolute difference as well. short stages are dominated by timer noise.
+			double minimum = m == NODE_MEMORY ? 0.0 : BASELINE_MIN_SECONDS;
+			if(after > before * (1.0 + tolerance) && after - before > minimum)
+			{
+				stream << " REGRESSION";
+				++regressions;
+			}
+			else if(after < before * (1.0 - tolerance) && before - after > minimum)
+			{
+				stream << " improved";
+			}
+			stream << "\n";
+		}
+	}
+
+	stream << regressions << " regressions (tolerance " << 100.0 * tolerance << "%)\n";
+	return regressions;
+}
+
+void BenchmarkBaseline::getMetrics(const BenchmarkResult& result, double* metrics)
+{
+	metrics[FRAME_TIME] = result.frameTimes.empty() ? -1.0 : result.getMedian();
+	metrics[TRAVERSAL_TIME] = 0.0;
+	for (int stage = 0; stage < StageTimer::STAGE_COUNT; ++stage)
+	{
+		if(StageTimer::isTraversal(stage)) metrics[TRAVERSAL_TIME] += result.stageTimes[stage];
+	}
+	metrics[CONSTRUCTION_TIME] = result.constructionTime;
+	metrics[NODE_MEMORY] = (double)result.nodeMemory;
+}
+
+std::string BenchmarkBaseline::getConfiguration(const BenchmarkResult& result)
+{
+	return makeConfiguration(result.model, result.method, result.camera, result.width, result.height, result.threads);
+}
+
+const char* BenchmarkBaseline::getMetricName(int metric)
+{
+	static const char* names[METRIC_COUNT] = { "median frame time", "traversal time", "construction time", "node memory" };
+	return names[metric];
+}
@@ -0,0 +1,51 @@
+#ifndef BENCHMARKBASELINE_HPP
+#define BENCHMARKBASELINE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "BenchmarkResult.hpp"
+
+// time differences below this many seconds are noise, whatever the tolerance
+#define BASELINE_MIN_SECONDS 0.001
+
+/*
+	regression gate of the benchmark mode. compares benchmark results with the JSON file of an earlier benchmark run
+	configuration by configuration (model, method, camera, resolution, threads). lower is better for every metric.
+	a metric regresses if it is more than the tolerance above the baseline.
+	the peak resident memory is not compared: it is the peak of the whole process, so it depends on the configurations run before.
+*/
+class BenchmarkBaseline
+{
+public:
+	enum METRIC
+	{
+		FRAME_TIME,	// median
+		TRAVERSAL_TIME,	// primary, shadow and reflection/refraction traversal stages
+		CONSTRUCTION_TIME,
+		NODE_MEMORY,
+		METRIC_COUNT
+	};
+
+	/// reads the results of an earlier benchmark run. returns false if the file cannot be read or parsed.
+	bool load(const char* fileName);
+
+	/// prints the comparison of each result with its baseline configuration. tolerance is relative, e.g. 0.1 for 10%.
+	/// returns the number of regressed metrics.
+	int compare(const std::vector<BenchmarkResult>& results, double tolerance, std::ostream& stream) const;
+
+	static void getMetrics(const BenchmarkResult& result, double* metrics);
+	static std::string getConfiguration(const BenchmarkResult& result);
+	static const char* getMetricName(int metric);
+
+private:
+	struct Entry
+	{
+		double metrics[METRIC_COUNT];	// negative if unknown
+	};
+	std::map<std::string, Entry> entries;	// by configuration
+};
+
+#endif
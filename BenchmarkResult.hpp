@@ -0,0 +1,171 @@
+#ifndef _BENCHMARKRESULT_H_
+#define _BENCHMARKRESULT_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "StageTimer.hpp"
+
+/// measurements of one benchmark configuration (model, method, camera, resolution, threads). printed as JSON object.
+struct BenchmarkResult
+{
+	std::string model;
+	std::string method;
+	std::string camera;	// camera file or "default"
+	int width;
+	int height;
+	int threads;
+	int warmupFrames;
+
+	std::vector<double> frameTimes;	// raytrace time of each measured frame in seconds
+	double stageTimes[StageTimer::STAGE_COUNT];	// average time per frame of each stage summed over the threads
+	double traversalEvents[PerfCounters::EVENT_COUNT];	// average hardware events per frame of the traversal stages. negative if not counted.
+
+	double constructionTime;
+	unsigned int treeHeight;
+	unsigned long innerNodes;
+	unsigned long leafNodes;
+
+	// see HierarchyStatistics. negative if the scene has no hierarchy.
+	double sahCost;
+	double surfaceRatio;
+
+	unsigned long nodeMemory;	// computed memory usage of the nodes
+	unsigned long triangleMemory;
+	unsigned long peakResidentMemory;	// of the whole process. 0 if unknown.
+
+	// intersection tests of the primary rays. measured with 1 thread only, negative otherwise.
+	double nodeTestsPerRay;
+	double triangleTestsPerRay;
+
+	BenchmarkResult()
+	{
+		width = 0;
+		height = 0;
+		threads = 0;
+		warmupFrames = 0;
+		constructionTime = -1.0;
+		treeHeight = 0;
+		innerNodes = 0;
+		leafNodes = 0;
+		sahCost = -1.0;
+		surfaceRatio = -1.0;
+		nodeMemory = 0;
+		triangleMemory = 0;
+		peakResidentMemory = 0;
+		nodeTestsPerRay = -1.0;
+		triangleTestsPerRay = -1.0;
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i) stageTimes[i] = 0.0;
+		for (int i = 0; i < PerfCounters::EVENT_COUNT; ++i) traversalEvents[i] = -1.0;
+	}
+
+	double getMean() const
+	{
+		if(frameTimes.empty()) return 0.0;
+		double sum = 0.0;
+		for (size_t i = 0; i < frameTimes.size(); ++i) sum += frameTimes[i];
+		return sum / frameTimes.size();
+	}
+
+	/// nearest-rank percentile of the frame times. p in [0,100]
+	double getPercentile(double p) const
+	{
+		if(frameTimes.empty()) return 0.0;
+		std::vector<double> sorted(frameTimes);
+		std::sort(sorted.begin(), sorted.end());
+
+		size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+		if(rank < 1) rank = 1;
+		if(rank > sorted.size()) rank = sorted.size();
+		return sorted[rank-1];
+	}
+
+	double getMedian() const
+	{
+		if(frameTimes.empty()) return 0.0;
+		std::vector<double> sorted(frameTimes);
+		std::sort(sorted.begin(), sorted.end());
+
+		size_t n = sorted.size();
+		return n % 2 ? sorted[n/2] : 0.5 * (sorted[n/2-1] + sorted[n/2]);
+	}
+
+	void printJSON(std::ostream& stream) const
+	{
+		stream << "\t{\n"
+			<< "\t\t\"model\": \"" << escape(model) << "\",\n"
+			<< "\t\t\"method\": \"" << escape(method) << "\",\n"
+			<< "\t\t\"camera\": \"" << escape(camera) << "\",\n"
+			<< "\t\t\"width\": " << width << ",\n"
+			<< "\t\t\"height\": " << height << ",\n"
+			<< "\t\t\"threads\": " << threads << ",\n"
+			<< "\t\t\"warmupFrames\": " << warmupFrames << ",\n"
+			<< "\t\t\"frames\": " << frameTimes.size() << ",\n"
+			<< "\t\t\"frameTime\": {\n"
+			<< "\t\t\t\"mean\": " << getMean() << ",\n"
+			<< "\t\t\t\"median\": " << getMedian() << ",\n"
+			<< "\t\t\t\"p95\": " << getPercentile(95) << ",\n"
+			<< "\t\t\t\"p99\": " << getPercentile(99) << ",\n"
+			<< "\t\t\t\"min\": " << getPercentile(0) << ",\n"
+			<< "\t\t\t\"max\": " << getPercentile(100) << "\n"
+			<< "\t\t},\n"
+			<< "\t\t\"stageTimes\": {\n";
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			stream << "\t\t\t\"" << StageTimer::getStageName(i) << "\": " << stageTimes[i] << (i+1 < StageTimer::STAGE_COUNT ? ",\n" : "\n");
+		}
+		stream << "\t\t},\n"
+			<< "\t\t\"traversalEvents\": {\n";
+		for (int i = 0; i < PerfCounters::EVENT_COUNT; ++i)
+		{
+			stream << "\t\t\t\"" << PerfCounters::getEventName(i) << "\": ";
+			printOptional(stream, traversalEvents[i]);
+			stream << (i+1 < PerfCounters::EVENT_COUNT ? ",\n" : "\n");
+		}
+		stream << "\t\t},\n"
+			<< "\t\t\"constructionTime\": " << constructionTime << ",\n"
+			<< "\t\t\"treeHeight\": " << treeHeight << ",\n"
+			<< "\t\t\"innerNodes\": " << innerNodes << ",\n"
+			<< "\t\t\"leafNodes\": " << leafNodes << ",\n"
+			<< "\t\t\"sahCost\": ";
+		printOptional(stream, sahCost);
+		stream << ",\n"
+			<< "\t\t\"surfaceRatio\": ";
+		printOptional(stream, surfaceRatio);
+		stream << ",\n"
+			<< "\t\t\"memory\": {\n"
+			<< "\t\t\t\"nodes\": " << nodeMemory << ",\n"
+			<< "\t\t\t\"triangles\": " << triangleMemory << ",\n"
+			<< "\t\t\t\"peakResident\": " << peakResidentMemory << "\n"
+			<< "\t\t},\n"
+			<< "\t\t\"nodeTestsPerRay\": ";
+		printOptional(stream, nodeTestsPerRay);
+		stream << ",\n"
+			<< "\t\t\"triangleTestsPerRay\": ";
+		printOptional(stream, triangleTestsPerRay);
+		stream << "\n"
+			<< "\t}";
+	}
+
+private:
+	static void printOptional(std::ostream& stream, double value)
+	{
+		if(value < 0.0) stream << "null";
+		else stream << value;
+	}
+
+	static std::string escape(const std::string& text)
+	{
+		std::string result;
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if(text[i] == '"' || text[i] == '\\') result += '\\';
+			result += text[i];
+		}
+		return result;
+	}
+};
+
+#endif
@@ -23,6 +23,9 @@ class Camera : public SIMDmemAligned
 	Camera(unsigned int xRes, unsigned int yRes, float fovy, vec pos, vec dir, vec up);
 
 	float getFov() { return fovy; }
+	vec getPosition() const { return pos; }
+	vec getDirection() const { return dir; }
+	vec getUp() const { return up; }
 
 	void set(vec pos, vec dir, vec up);
 
@@ -11,7 +11,15 @@
 #include <string>
 
 //#include <GL/glew.h>
-#include <GL/glut.h>
+#ifndef HEADLESS
+	#include <GL/glut.h>
+#else
+	// glut mouse constants for builds without glut
+	#define GLUT_LEFT_BUTTON 0
+	#define GLUT_MIDDLE_BUTTON 1
+	#define GLUT_RIGHT_BUTTON 2
+	#define GLUT_DOWN 0
+#endif
 
 //#include <algebra.h>
 
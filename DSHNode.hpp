@@ -0,0 +1,85 @@
+#ifndef DSHNODE_HPP
+#define DSHNODE_HPP
+
+#include "XHierarchyConfig.hpp"
+
+/*
+	node of the dual slab hierarchy. like SSHNode, but two planes cut the box of the parent:
+	both sides of one axis or two sides of different axes.
+*/
+struct DSHNode
+{
+	// flags //
+
+	enum FLAGS {
+		NEAR_FLAG = 8,	// b0000001000	the geometry is on the lower side of the first slab (slab at x=5 --> geometry bounds x < 5)
+		LEAF_FLAG = 4,	// b0000000100	this is a leaf node
+		#ifdef TRAVERSE_ORDERED
+			SECOND_NEAR_FLAG = 256	// b100000000	the geometry is on the lower side of the second slab
+		#else
+			SECOND_NEAR_FLAG = 64	// b1000000	the geometry is on the lower side of the second slab
+		#endif
+	};
+	enum AXIS
+	{
+		AXIS_X = 0,	// b00000	the slab is orthogonal to the x axis
+		AXIS_Y = 1,	// b00001	the slab is orthogonal to the y axis
+		AXIS_Z = 2	// b00010	the slab is orthogonal to the z axis
+	};
+
+	#ifdef TRAVERSE_ORDERED
+		// 9 bits for flags: second near, second slabaxis, splitaxis, near, leaf/slabaxis
+		#define DSH_FLAG_MASK_BITS 9
+		#define DSH_FLAG_MASK 511
+		#define DSH_SECOND_AXIS_SHIFT 6
+	#else
+		// 7 bits for flags: second near, second slabaxis, near, leaf/slabaxis
+		#define DSH_FLAG_MASK_BITS 7
+		#define DSH_FLAG_MASK 127
+		#define DSH_SECOND_AXIS_SHIFT 4
+	#endif
+
+	#define DSH_GEOM_OR_CHILD_INDEX_MASK 		(~DSH_FLAG_MASK)
+
+	#define DSH_PACK_GEOM_OR_CHILD_INDEX(v) (((v)<<DSH_FLAG_MASK_BITS)&DSH_GEOM_OR_CHILD_INDEX_MASK)
+	#define DSH_UNPACK_GEOM_OR_CHILD_INDEX(v) (((v) & DSH_GEOM_OR_CHILD_INDEX_MASK)>>DSH_FLAG_MASK_BITS)
+
+	// data //
+
+	union {
+		x_node_child_id_t geo_child_index;
+		x_node_child_id_t flags;
+	};
+	float plane;
+	float secondPlane;
+
+	static const unsigned long memSize = sizeof(x_node_child_id_t) + 2*sizeof(float);
+
+	// methods //
+
+	#ifdef TRAVERSE_ORDERED
+		inline x_node_child_id_t getSplitAxis() const { return (flags >> 4) & 0x03; }
+		inline void setSplitAxis(AXIS axis) { flags |= (x_node_child_id_t)axis << 4; }
+	#endif
+
+	inline void setSlabs(AXIS _axis, bool _near, float pos, AXIS _secondAxis, bool _secondNear, float secondPos)
+	{
+		flags = ((_near ? (_axis|NEAR_FLAG) : _axis) | ((x_node_child_id_t)_secondAxis << DSH_SECOND_AXIS_SHIFT) | (_secondNear ? SECOND_NEAR_FLAG : 0)) & DSH_FLAG_MASK;
+		plane = pos;
+		secondPlane = secondPos;
+	}
+	inline x_node_child_id_t getSlabAxis() const { return flags & 0x03; }
+	inline x_node_child_id_t getSecondSlabAxis() const { return (flags >> DSH_SECOND_AXIS_SHIFT) & 0x03; }
+
+	inline void setLeaf(x_node_child_id_t geomIndex) { geo_child_index = DSH_PACK_GEOM_OR_CHILD_INDEX(geomIndex) | (flags&DSH_FLAG_MASK) | (x_node_child_id_t)LEAF_FLAG; }
+	inline x_node_child_id_t getGeomIndex() const { return DSH_UNPACK_GEOM_OR_CHILD_INDEX(geo_child_index); }
+
+	inline void setInner(x_node_child_id_t childId) { geo_child_index = DSH_PACK_GEOM_OR_CHILD_INDEX(childId) | (flags&DSH_FLAG_MASK); }
+	inline x_node_child_id_t getChildId() const { return DSH_UNPACK_GEOM_OR_CHILD_INDEX(geo_child_index); }
+
+	inline bool isLeaf() const { return flags & (x_node_child_id_t)LEAF_FLAG; }
+	inline bool isNear() const { return flags & (x_node_child_id_t)NEAR_FLAG; }
+	inline bool isSecondNear() const { return flags & (x_node_child_id_t)SECOND_NEAR_FLAG; }
+};
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef HIERARCHYANALYZER_HPP
+#define HIERARCHYANALYZER_HPP
+
+#include <vector>
+
+#include "MultiThreading.hpp"
+#include "HierarchyStatistics.hpp"
+#include "AABBox.hpp"
+#include "Triangle.hpp"
+#include "SSHNode.hpp"
+#include "BVHNode.hpp"
+#include "DSHNode.hpp"
+#include "HybridNode.hpp"
+
+/// compensated (Kahan) summation. sums of many small surface ratios lose precision in plain double sums.
+struct KahanSum
+{
+	double sum;
+	double compensation;	// negative of the low order bits lost in sum
+
+	KahanSum() : sum(0.0), compensation(0.0) {}
+
+	inline void add(double value)
+	{
+		double y = value - compensation;
+		double t = sum + y;
+		compensation = (t - sum) - y;
+		sum = t;
+	}
+
+	inline void add(const KahanSum& other)
+	{
+		add(other.sum);
+		add(-other.compensation);
+	}
+
+	inline double get() const { return sum - compensation; }
+};
+
+/// box the SSH traversal tests: the parent box cut by the slab of the node
+inline AABBox getTraversalBox(const SSHNode& node, const AABBox& parentBox)
+{
+	AABBox box(parentBox);
+	if(node.isNear()) box.min[node.getSlabAxis()] = node.plane;
+	else box.max[node.getSlabAxis()] = node.plane;
+	return box;
+}
+
+/// box the DSH traversal tests: the parent box cut by both slabs of the node
+inline AABBox getTraversalBox(const DSHNode& node, const AABBox& parentBox)
+{
+	AABBox box(parentBox);
+	if(node.isNear()) box.min[node.getSlabAxis()] = node.plane;
+	else box.max[node.getSlabAxis()] = node.plane;
+	if(node.isSecondNear()) box.min[node.getSecondSlabAxis()] = node.secondPlane;
+	else box.max[node.getSecondSlabAxis()] = node.secondPlane;
+	return box;
+}
+
+/// box the BVH traversal tests
+inline AABBox getTraversalBox(const BVHNode& node, const AABBox&)
+{
+	AABBox box;
+	box.min = node.min;
+	box.max = node.max;
+	return box;
+}
+
+/// box the hybrid traversal tests: the box of a box node, otherwise the parent box cut by the slab
+struct HybridTraversalBox
+{
+	const HybridBox* boxes;
+
+	HybridTraversalBox(const HybridBox* boxes) : boxes(boxes) {}
+
+	AABBox operator()(const HybridNode& node, const AABBox& parentBox) const
+	{
+		AABBox box(parentBox);
+		if(node.isBox())
+		{
+			box.min = boxes[node.boxIndex].min;
+			box.max = boxes[node.boxIndex].max;
+		}
+		else if(node.isNear()) box.min[node.getSlabAxis()] = node.plane;
+		else box.max[node.getSlabAxis()] = node.plane;
+		return box;
+	}
+};
+
+/*
+	post-build analysis of the flat node array of a hierarchy (see HierarchyStatistics).
+	the boxes are computed in one pass down and one pass up the tree, the statistics of the nodes in parallel.
+*/
+template<typename Node>
+class HierarchyAnalyzer
+{
+public:
+	/// traversal boxes of the nodes which know their box by themselves (see getTraversalBox)
+	struct NodeTraversalBox
+	{
+		AABBox operator()(const Node& node, const AABBox& parentBox) const { return getTraversalBox(node, parentBox); }
+	};
+
+	static void analyze(const Node* nodes, unsigned long nodeCount, const Triangle* triangles, const AABBox& sceneBounds, HierarchyStatistics& out)
+	{
+		analyze(nodes, nodeCount, triangles, sceneBounds, NodeTraversalBox(), out);
+	}
+
+	/// getTraversalBox(node, parentBox) returns the box the traversal tests for a node
+	template<typename TraversalBox>
+	static void analyze(const Node* nodes, unsigned long nodeCount, const Triangle* triangles, const AABBox& sceneBounds, const TraversalBox& getTraversalBox, HierarchyStatistics& out)
+	{
+		out.clear();
+		if(nodeCount == 0) return;
+
+		std::vector<AABBox> boxes(nodeCount);	// tested by the traversal
+		std::vector<AABBox> tightBoxes(nodeCount);	// bounds of the triangles below the node
+		std::vector<unsigned int> depths(nodeCount, 0);
+		std::vector<unsigned long> order;	// parents before their children
+		order.reserve(nodeCount);
+
+		// down: traversal boxes and depths
+		boxes[0] = getTraversalBox(nodes[0], sceneBounds);
+		std::vector<unsigned long> stack(1, 0ul);
+		while(!stack.empty())
+		{
+			unsigned long i = stack.back();
+			stack.pop_back();
+			order.push_back(i);
+
+			if(nodes[i].isLeaf()) continue;
+
+			unsigned long child = nodes[i].getChildId();
+			for (unsigned long c = child; c < child+2; ++c)
+			{
+				boxes[c] = getTraversalBox(nodes[c], boxes[i]);
+				depths[c] = depths[i] + 1;
+				stack.push_back(c);
+			}
+		}
+
+		// up: tightest boxes
+		for (long k = (long)order.size()-1; k >= 0; --k)
+		{
+			unsigned long i = order[k];
+			if(nodes[i].isLeaf())
+			{
+				tightBoxes[i] = triangles[nodes[i].getGeomIndex()].getBounds();
+			}
+			else
+			{
+				unsigned long child = nodes[i].getChildId();
+				tightBoxes[i] = tightBoxes[child];
+				tightBoxes[i].extend(tightBoxes[child+1]);
+			}
+		}
+
+		unsigned int maxDepth = 0;
+		for (size_t k = 0; k < order.size(); ++k)
+		{
+			if(depths[order[k]] > maxDepth) maxDepth = depths[order[k]];
+		}
+
+		double rootSurface = surface(boxes[0]);
+		double tightRootSurface = surface(tightBoxes[0]);
+		if(rootSurface <= 0.0) rootSurface = 1.0;
+		if(tightRootSurface <= 0.0) tightRootSurface = 1.0;
+
+		KahanSum nodeTests, triangleTests, tightNodeTests, tightTriangleTests, ratioSum, leafDepthSum, leafSurfaceSum;
+		unsigned long ratioCount = 0;
+		out.minLeafDepth = maxDepth;
+		out.nodesPerDepth.assign(maxDepth+1, 0);
+		out.leavesPerDepth.assign(maxDepth+1, 0);
+
+		const long reachable = (long)order.size();
+
+		#pragma omp parallel
+		{
+			// per thread sums. merged at the end.
+			KahanSum threadNodeTests, threadTriangleTests, threadTightNodeTests, threadTightTriangleTests, threadRatioSum, threadLeafDepthSum, threadLeafSurfaceSum;
+			HierarchyStatistics local;
+			local.minLeafDepth = maxDepth;
+			local.nodesPerDepth.assign(maxDepth+1, 0);
+			local.leavesPerDepth.assign(maxDepth+1, 0);
+			unsigned long threadRatioCount = 0;
+
+			#pragma omp for schedule(static)
+			for (long k = 0; k < reachable; ++k)
+			{
+				unsigned long i = order[k];
+				double area = surface(boxes[i]);
+				double tightArea = surface(tightBoxes[i]);
+				unsigned int depth = depths[i];
+
+				++local.nodesPerDepth[depth];
+
+				if(nodes[i].isLeaf())
+				{
+					++local.leafNodes;
+					++local.leavesPerDepth[depth];
+					if(depth < local.minLeafDepth) local.minLeafDepth = depth;
+					threadLeafDepthSum.add(depth);
+					threadLeafSurfaceSum.add(area / rootSurface);
+
+					// the triangle of the leaf is tested if the leaf box is hit
+					threadTriangleTests.add(area / rootSurface);
+					threadTightTriangleTests.add(tightArea / tightRootSurface);
+				}
+				else
+				{
+					++local.innerNodes;
+
+					// both children are tested if the node box is hit
+					threadNodeTests.add(2.0 * area / rootSurface);
+					threadTightNodeTests.add(2.0 * tightArea / tightRootSurface);
+				}
+
+				if(tightArea > 0.0)
+				{
+					double ratio = area / tightArea;
+					threadRatioSum.add(ratio);
+					++threadRatioCount;
+					if(ratio > local.maxSurfaceRatio) local.maxSurfaceRatio = ratio;
+
+					int bucket = 0;
+					while(bucket < SURFACE_RATIO_BUCKETS-1 && ratio >= HierarchyStatistics::getRatioBucketLimit(bucket)) ++bucket;
+					++local.surfaceRatioHistogram[bucket];
+				}
+				else
+				{
+					++local.degenerateNodes;
+				}
+			}
+
+			#pragma omp critical
+			{
+				nodeTests.add(threadNodeTests);
+				triangleTests.add(threadTriangleTests);
+				tightNodeTests.add(threadTightNodeTests);
+				tightTriangleTests.add(threadTightTriangleTests);
+				ratioSum.add(threadRatioSum);
+				leafDepthSum.add(threadLeafDepthSum);
+				leafSurfaceSum.add(threadLeafSurfaceSum);
+				ratioCount += threadRatioCount;
+
+				out.innerNodes += local.innerNodes;
+				out.leafNodes += local.leafNodes;
+				out.degenerateNodes += local.degenerateNodes;
+				if(local.maxSurfaceRatio > out.maxSurfaceRatio) out.maxSurfaceRatio = local.maxSurfaceRatio;
+				if(local.minLeafDepth < out.minLeafDepth) out.minLeafDepth = local.minLeafDepth;
+				for (int b = 0; b < SURFACE_RATIO_BUCKETS; ++b) out.surfaceRatioHistogram[b] += local.surfaceRatioHistogram[b];
+				for (unsigned int d = 0; d <= maxDepth; ++d)
+				{
+					out.nodesPerDepth[d] += local.nodesPerDepth[d];
+					out.leavesPerDepth[d] += local.leavesPerDepth[d];
+				}
+			}
+		}
+
+		// the root node is tested by every ray
+		out.expectedNodeTests = 1.0 + nodeTests.get();
+		out.expectedTriangleTests = triangleTests.get();
+		out.tightNodeTests = 1.0 + tightNodeTests.get();
+		out.tightTriangleTests = tightTriangleTests.get();
+		out.meanSurfaceRatio = ratioCount ? ratioSum.get() / ratioCount : 1.0;
+		out.height = maxDepth;
+		if(out.leafNodes)
+		{
+			out.meanLeafDepth = leafDepthSum.get() / out.leafNodes;
+			out.meanLeafSurface = leafSurfaceSum.get() / out.leafNodes;
+		}
+	}
+
+private:
+	static double surface(const AABBox& box)
+	{
+		double x = box.max.x > box.min.x ? (double)box.max.x - box.min.x : 0.0;
+		double y = box.max.y > box.min.y ? (double)box.max.y - box.min.y : 0.0;
+		double z = box.max.z > box.min.z ? (double)box.max.z - box.min.z : 0.0;
+		return 2.0 * (x*y + y*z + z*x);
+	}
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef HIERARCHYSTATISTICS_HPP
+#define HIERARCHYSTATISTICS_HPP
+
+#include <iostream>
+#include <vector>
+
+// buckets of the node surface ratio histogram. see HierarchyStatistics::getRatioBucketLimit
+#define SURFACE_RATIO_BUCKETS 6
+
+/*
+	quality of a built hierarchy. computed by HierarchyAnalyzer after construction, so the builder is not slowed down.
+	the expected tests per ray follow the surface area heuristic: a ray which hits the scene bounds hits a box with
+	the probability of the surface area ratio of the box and the scene bounds.
+*/
+struct HierarchyStatistics
+{
+	unsigned long innerNodes;
+	unsigned long leafNodes;
+	unsigned int height;
+
+	/// node and triangle tests per ray for uniformly distributed rays. their sum is the SAH cost.
+	double expectedNodeTests;
+	double expectedTriangleTests;
+
+	/// the same for the tightest box of each node, i.e. a BVH with the same splits. differs from the above for SSH only.
+	double tightNodeTests;
+	double tightTriangleTests;
+
+	/// surface of the box the traversal tests divided by the surface of the tightest box. 1 for BVH.
+	double meanSurfaceRatio;
+	double maxSurfaceRatio;
+	unsigned long surfaceRatioHistogram[SURFACE_RATIO_BUCKETS];
+	unsigned long degenerateNodes;	// tightest box without surface. not in the ratios.
+
+	std::vector<unsigned long> nodesPerDepth;
+	std::vector<unsigned long> leavesPerDepth;
+	unsigned int minLeafDepth;
+	double meanLeafDepth;
+	double meanLeafSurface;	// relative to the scene bounds
+
+	HierarchyStatistics()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		innerNodes = 0;
+		leafNodes = 0;
+		height = 0;
+		expectedNodeTests = 0.0;
+		expectedTriangleTests = 0.0;
+		tightNodeTests = 0.0;
+		tightTriangleTests = 0.0;
+		meanSurfaceRatio = 0.0;
+		maxSurfaceRatio = 0.0;
+		for (int i = 0; i < SURFACE_RATIO_BUCKETS; ++i) surfaceRatioHistogram[i] = 0;
+		degenerateNodes = 0;
+		nodesPerDepth.clear();
+		leavesPerDepth.clear();
+		minLeafDepth = 0;
+		meanLeafDepth = 0.0;
+		meanLeafSurface = 0.0;
+	}
+
+	double getSAHCost() const { return expectedNodeTests + expectedTriangleTests; }
+
+	/// upper limit of a bucket of the surface ratio histogram. the last bucket has no limit.
+	static double getRatioBucketLimit(int bucket)
+	{
+		static const double limits[SURFACE_RATIO_BUCKETS-1] = { 1.01, 1.1, 1.5, 2.0, 4.0 };
+		return limits[bucket];
+	}
+
+	void print(std::ostream& stream) const
+	{
+		stream << "SAH cost: " << getSAHCost() << " (" << expectedNodeTests << " node tests + " << expectedTriangleTests << " triangle tests per ray)\n"
+			<< "SAH cost with tightest boxes: " << tightNodeTests + tightTriangleTests << "\n"
+			<< "average node surface ratio approx/real: " << meanSurfaceRatio << "\n"
+			<< "maximum node surface ratio approx/real: " << maxSurfaceRatio << "\n"
+			<< "node surface ratio histogram:";
+		for (int i = 0; i < SURFACE_RATIO_BUCKETS; ++i)
+		{
+			if(i < SURFACE_RATIO_BUCKETS-1) stream << " <" << getRatioBucketLimit(i) << ": ";
+			else stream << " >=" << getRatioBucketLimit(i-1) << ": ";
+			stream << surfaceRatioHistogram[i];
+		}
+		stream << "\n"
+			<< "nodes without surface: " << degenerateNodes << "\n"
+			<< "leaf depth: min " << minLeafDepth << ", average " << meanLeafDepth << ", max " << height << "\n"
+			<< "average leaf surface / scene surface: " << meanLeafSurface << "\n"
+			<< "leaves per depth:";
+		for (size_t depth = 0; depth < leavesPerDepth.size(); ++depth)
+		{
+			if(leavesPerDepth[depth] != 0) stream << " " << depth << ":" << leavesPerDepth[depth];
+		}
+		stream << "\n"
+			<< "nodes per depth:";
+		for (size_t depth = 0; depth < nodesPerDepth.size(); ++depth)
+		{
+			stream << " " << depth << ":" << nodesPerDepth[depth];
+		}
+		stream << "\n";
+	}
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef HYBRIDNODE_HPP
+#define HYBRIDNODE_HPP
+
+#include "XHierarchyConfig.hpp"
+
+#include "vecmath.h"
+
+/// bounding box of a box node of the hybrid hierarchy. stored next to the node array (see HybridNode::boxIndex).
+struct HybridBox
+{
+	vec min;
+	vec max;
+
+	static const unsigned long memSize = 2*sizeof(vec);
+};
+
+/*
+	node of the hybrid hierarchy. a slab node is an SSH node: one plane cuts the box of the parent.
+	a box node has BOX_FLAG set and the index of its full bounding box instead of the plane, so it has the size of a slab node.
+*/
+struct HybridNode
+{
+	// flags //
+
+	enum FLAGS {
+		NEAR_FLAG = 8,	// b0001000	the geometry is on the lower side of the slab (slab at x=5 --> geometry bounds x < 5)
+		LEAF_FLAG = 4,	// b0000100	this is a leaf node
+		#ifdef TRAVERSE_ORDERED
+			BOX_FLAG = 64	// b1000000	the node is tested with the box boxIndex instead of the slab
+		#else
+			BOX_FLAG = 16	// b10000	the node is tested with the box boxIndex instead of the slab
+		#endif
+	};
+	enum AXIS
+	{
+		AXIS_X = 0,	// b00000	the slab is orthogonal to the x axis
+		AXIS_Y = 1,	// b00001	the slab is orthogonal to the y axis
+		AXIS_Z = 2	// b00010	the slab is orthogonal to the z axis
+	};
+
+	#ifdef TRAVERSE_ORDERED
+		// 7 bits for flags: box, splitaxis, near, leaf/slabaxis
+		#define HYBRID_FLAG_MASK_BITS 7
+		#define HYBRID_FLAG_MASK 127
+	#else
+		// 5 bits for flags: box, near, leaf/slabaxis
+		#define HYBRID_FLAG_MASK_BITS 5
+		#define HYBRID_FLAG_MASK 31
+	#endif
+
+	// flags of the volume. the others are kept when the volume is set.
+	#define HYBRID_VOLUME_MASK ((x_node_child_id_t)(0x03 | NEAR_FLAG | BOX_FLAG))
+
+	#define HYBRID_GEOM_OR_CHILD_INDEX_MASK 		(~HYBRID_FLAG_MASK)
+
+	#define HYBRID_PACK_GEOM_OR_CHILD_INDEX(v) (((v)<<HYBRID_FLAG_MASK_BITS)&HYBRID_GEOM_OR_CHILD_INDEX_MASK)
+	#define HYBRID_UNPACK_GEOM_OR_CHILD_INDEX(v) (((v) & HYBRID_GEOM_OR_CHILD_INDEX_MASK)>>HYBRID_FLAG_MASK_BITS)
+
+	// data //
+
+	union {
+		x_node_child_id_t geo_child_index;
+		x_node_child_id_t flags;
+	};
+	union {
+		float plane;	// slab node
+		unsigned int boxIndex;	// box node
+	};
+
+	static const unsigned long memSize = sizeof(x_node_child_id_t) + sizeof(float);
+
+	// methods //
+
+	#ifdef TRAVERSE_ORDERED
+		inline x_node_child_id_t getSplitAxis() const { return (flags >> 4) & 0x03; }
+		inline void setSplitAxis(AXIS axis) { flags |= (x_node_child_id_t)axis << 4; }
+	#endif
+
+	// unlike SSHNode::setSlab the volume can be set after the node has been linked
+	inline void setSlab(AXIS _axis, bool _near, float pos) { flags = (flags & ~HYBRID_VOLUME_MASK) | (_near ? (_axis|NEAR_FLAG) : _axis); plane = pos; }
+	inline x_node_child_id_t getSlabAxis() const { return flags & 0x03; }
+
+	inline void setBox(unsigned int index) { flags = (flags & ~HYBRID_VOLUME_MASK) | (x_node_child_id_t)BOX_FLAG; boxIndex = index; }
+
+	inline void setLeaf(x_node_child_id_t geomIndex) { geo_child_index = HYBRID_PACK_GEOM_OR_CHILD_INDEX(geomIndex) | (flags&HYBRID_FLAG_MASK) | (x_node_child_id_t)LEAF_FLAG; }
+	inline x_node_child_id_t getGeomIndex() const { return HYBRID_UNPACK_GEOM_OR_CHILD_INDEX(geo_child_index); }
+
+	inline void setInner(x_node_child_id_t childId) { geo_child_index = HYBRID_PACK_GEOM_OR_CHILD_INDEX(childId) | (flags&HYBRID_FLAG_MASK); }
+	inline x_node_child_id_t getChildId() const { return HYBRID_UNPACK_GEOM_OR_CHILD_INDEX(geo_child_index); }
+
+	inline bool isLeaf() const { return flags & (x_node_child_id_t)LEAF_FLAG; }
+	inline bool isNear() const { return flags & (x_node_child_id_t)NEAR_FLAG; }
+	inline bool isBox() const { return flags & (x_node_child_id_t)BOX_FLAG; }
+};
+
+#endif
@@ -13,6 +13,7 @@
 class IOpenGLImage
 {
 public:
+	virtual ~IOpenGLImage() {}
 	virtual void beginWrite() = 0;
 	virtual void setPixel(int x, int y, vec color) = 0;
 	virtual void endWrite() = 0;
@@ -83,6 +83,8 @@ public:
 	void writePPM(const std::string& fileName, bool clamp = true);
 
 	const std::string& getFileName() { return filename; }
+	int getWidth() const { return resX; }
+	int getHeight() const { return resY; }
 
 protected:
 	std::string filename;
@@ -8,9 +8,42 @@
 #ifndef _INTERSECTRESULT_H_
 #define _INTERSECTRESULT_H_
 
+#include <stddef.h>
+
+/// traversal cost of each ray of a packet. used for heatmaps.
+struct LaneCounters
+{
+	unsigned int nodeVisits[4];	// nodes tested while the ray segment was not empty
+	unsigned int triangleTests[4];	// triangles tested in leaves the ray hits
+
+	void clear()
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			nodeVisits[i] = 0;
+			triangleTests[i] = 0;
+		}
+	}
+
+	/// adds one to the counters of the lanes set in mask (see qmask::mask)
+	static inline void add(unsigned int counters[4], int mask)
+	{
+		counters[0] += mask & 1;
+		counters[1] += (mask >> 1) & 1;
+		counters[2] += (mask >> 2) & 1;
+		counters[3] += (mask >> 3) & 1;
+	}
+};
+
 struct IntersectDetails
 {
 	unsigned long rayNodeIntersections;
+
+	/// one entry per traversed packet which the traversal adds the cost of each lane to. NULL if not needed.
+	/// supported by the hierarchies only.
+	LaneCounters* lanes;
+
+	IntersectDetails() : rayNodeIntersections(0), lanes(NULL) {}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <string.h>
+
+#ifndef WINDOWS
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	// full barrier of compiler and cpu between the sequence and the values
+	#define LIVE_METRICS_BARRIER() __sync_synchronize()
+#endif
+
+#include "LiveMetrics.hpp"
+
+static const char LIVE_METRICS_MAGIC[8] = { 'S', 'S', 'H', 'L', 'I', 'V', 'E', '1' };
+
+// reads of a reader before it gives up on a writer in the middle of an update
+#define LIVE_METRICS_RETRIES 1000
+
+LiveMetrics::LiveMetrics() : segment(NULL), start(0.0), frames(0)
+{
+}
+
+LiveMetrics::~LiveMetrics()
+{
+	close();
+}
+
+bool LiveMetrics::open(const char* name)
+{
+	close();
+
+#ifdef WINDOWS
+	return false;
+#else
+	int descriptor = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if(descriptor < 0) return false;
+
+	void* memory = MAP_FAILED;
+	if(ftruncate(descriptor, sizeof(LiveMetricsSegment)) == 0)
+	{
+		memory = mmap(NULL, sizeof(LiveMetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	}
+	::close(descriptor);	// the mapping stays valid
+
+	if(memory == MAP_FAILED)
+	{
+		shm_unlink(name);
+		return false;
+	}
+
+	segment = (LiveMetricsSegment*)memory;
+	memset(segment, 0, sizeof(LiveMetricsSegment));
+	memcpy(segment->magic, LIVE_METRICS_MAGIC, sizeof(segment->magic));
+	this->name = name;
+	start = TimeMeasurement::now();
+	frames = 0;
+	return true;
+#endif
+}
+
+void LiveMetrics::close()
+{
+	if(!segment) return;
+
+#ifndef WINDOWS
+	munmap(segment, sizeof(LiveMetricsSegment));
+	shm_unlink(name.c_str());
+#endif
+	segment = NULL;
+}
+
+void LiveMetrics::publish(LiveMetricsValues& values)
+{
+	if(!segment) return;
+
+	double now = TimeMeasurement::now();
+	values.frame = frames;
+	values.time = now - start;
+	values.residentMemory = getResidentMemory();
+
+	// the window ends with this frame. its rays are spread over the time since the end of the oldest frame in the window.
+	unsigned int count = frames < LIVE_METRICS_WINDOW ? (unsigned int)frames : LIVE_METRICS_WINDOW;
+	unsigned long windowRays = values.rays;
+	for (unsigned int i = 1; i < count; ++i)
+	{
+		windowRays += frameRays[(frames - i) % LIVE_METRICS_WINDOW];
+	}
+	double oldestEnd = count != 0 ? frameEnds[(frames - count) % LIVE_METRICS_WINDOW] : 0.0;
+	double span = count != 0 ? now - oldestEnd : values.frameTime;
+	values.framesPerSecond = span > 0.0 ? (count != 0 ? count : 1) / span : 0.0;
+	values.raysPerSecond = span > 0.0 ? windowRays / span : 0.0;
+
+	frameEnds[frames % LIVE_METRICS_WINDOW] = now;
+	frameRays[frames % LIVE_METRICS_WINDOW] = values.rays;
+	++frames;
+
+#ifndef WINDOWS
+	++segment->sequence;
+	LIVE_METRICS_BARRIER();
+	memcpy(&segment->values, &values, sizeof(values));
+	LIVE_METRICS_BARRIER();
+	++segment->sequence;
+#endif
+}
+
+const LiveMetricsSegment* LiveMetrics::attach(const char* name)
+{
+#ifdef WINDOWS
+	return NULL;
+#else
+	int descriptor = shm_open(name, O_RDONLY, 0);
+	if(descriptor < 0) return NULL;
+
+	struct stat status;
+	void* memory = MAP_FAILED;
+	if(fstat(descriptor, &status) == 0 && status.st_size >= (off_t)sizeof(LiveMetricsSegment))
+	{
+		memory = mmap(NULL, sizeof(LiveMetricsSegment), PROT_READ, MAP_SHARED, descriptor, 0);
+	}
+	::close(descriptor);
+	if(memory == MAP_FAILED) return NULL;
+
+	const LiveMetricsSegment* segment = (const LiveMetricsSegment*)memory;
+	if(memcmp(segment->magic, LIVE_METRICS_MAGIC, sizeof(segment->magic)) != 0)
+	{
+		detach(segment);
+		return NULL;
+	}
+	return segment;
+#endif
+}
+
+void LiveMetrics::detach(const LiveMetricsSegment* segment)
+{
+#ifndef WINDOWS
+	if(segment) munmap((void*)segment, sizeof(LiveMetricsSegment));
+#endif
+}
+
+bool LiveMetrics::read(const LiveMetricsSegment* segment, LiveMetricsValues& values)
+{
+#ifdef WINDOWS
+	return false;
+#else
+	for (int i = 0; i < LIVE_METRICS_RETRIES; ++i)
+	{
+		unsigned long before = segment->sequence;
+		LIVE_METRICS_BARRIER();
+		memcpy(&values, (const void*)&segment->values, sizeof(values));
+		LIVE_METRICS_BARRIER();
+		unsigned long after = segment->sequence;
+
+		if(before == after && (before & 1) == 0) return true;
+	}
+	return false;
+#endif
+}
+
+unsigned long LiveMetrics::getResidentMemory()
+{
+#ifdef WINDOWS
+	return 0;
+#else
+	// second value of statm: resident pages
+	FILE* file = fopen("/proc/self/statm", "r");
+	if(!file) return 0;
+	unsigned long size = 0, resident = 0;
+	int read = fscanf(file, "%lu %lu", &size, &resident);
+	fclose(file);
+	return read == 2 ? resident * (unsigned long)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
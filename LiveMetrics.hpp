@@ -0,0 +1,89 @@
+#ifndef LIVEMETRICS_HPP
+#define LIVEMETRICS_HPP
+
+#include <string>
+
+#include "StageTimer.hpp"
+
+// frames of the rolling frame rate and ray rate
+#define LIVE_METRICS_WINDOW 16
+
+/// values of the last frame. times in seconds, memory in bytes. counts which are not measured are 0.
+struct LiveMetricsValues
+{
+	unsigned long frame;	// frames published since the segment was created
+	double time;	// end of the frame, seconds since the segment was created
+	double framesPerSecond;	// over the last LIVE_METRICS_WINDOW frames
+	double raysPerSecond;	// over the last LIVE_METRICS_WINDOW frames
+	double frameTime;	// render time of the last frame
+	unsigned long rays;	// primary rays of the last frame, plus the secondary rays with the measurements
+	unsigned long nodeTests;	// packet/node tests of the primary rays of the last frame. needs the measurements and a single thread
+	unsigned long triangleTests;	// needs the measurements and a single thread
+	double stageTimes[StageTimer::STAGE_COUNT];	// of the last frame, summed over the threads. needs the measurements.
+	unsigned long nodeMemory;	// of the acceleration structure
+	unsigned long residentMemory;	// of the process
+	int width;
+	int height;
+	int threads;
+	char model[128];
+	char method[16];
+};
+
+/// layout of the shared memory segment
+struct LiveMetricsSegment
+{
+	char magic[8];
+	volatile unsigned long sequence;	// odd while the writer updates the values
+	LiveMetricsValues values;
+};
+
+/*
+	publishes the metrics of each frame to a POSIX shared memory segment, so a monitoring process can read them while
+	the renderer runs (see livemetrics.cpp). unlike printing to stdout, publishing costs only a copy of the values per frame.
+	the values are guarded by a sequence lock: the writer makes the sequence odd, writes and makes it even again.
+	a reader copies the values and retries if the sequence was odd or changed meanwhile, so the writer never waits.
+	other platforms than linux have no segment.
+*/
+class LiveMetrics
+{
+public:
+	LiveMetrics();
+	~LiveMetrics();
+
+	/// creates the segment, e.g. "/simdtrace". returns false if it cannot be created.
+	bool open(const char* name);
+
+	/// removes the segment
+	void close();
+
+	bool isOpen() const { return segment != NULL; }
+
+	/// publishes the values of a frame. frame, time, framesPerSecond, raysPerSecond and residentMemory are set here.
+	void publish(LiveMetricsValues& values);
+
+	/// maps an existing segment read-only. returns NULL if there is none.
+	static const LiveMetricsSegment* attach(const char* name);
+	static void detach(const LiveMetricsSegment* segment);
+
+	/// consistent copy of the values. returns false if the writer did not finish an update within a few retries.
+	static bool read(const LiveMetricsSegment* segment, LiveMetricsValues& values);
+
+	/// current resident memory of the process. 0 if unknown.
+	static unsigned long getResidentMemory();
+
+private:
+	LiveMetricsSegment* segment;
+	std::string name;
+	double start;
+
+	// end time and rays of the last frames. ring buffer.
+	double frameEnds[LIVE_METRICS_WINDOW];
+	unsigned long frameRays[LIVE_METRICS_WINDOW];
+	unsigned long frames;
+
+	// not copyable
+	LiveMetrics(const LiveMetrics&);
+	LiveMetrics& operator=(const LiveMetrics&);
+};
+
+#endif
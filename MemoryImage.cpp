@@ -0,0 +1,33 @@
+#include "MemoryImage.hpp"
+
+MemoryImage::MemoryImage(unsigned int width, unsigned int height) : img(width, height)
+{
+}
+
+void MemoryImage::beginWrite()
+{
+}
+
+void MemoryImage::endWrite()
+{
+}
+
+void MemoryImage::setPixel(int x, int y, vec color)
+{
+	img[y][x] = color;
+}
+
+vec* MemoryImage::operator[](int y)
+{
+	return img[y];
+}
+
+void MemoryImage::drawFullscreen()
+{
+	// nothing to display
+}
+
+void MemoryImage::saveToFile(const char* filename)
+{
+	img.writePPM(filename, true);
+}
@@ -0,0 +1,26 @@
+#ifndef _MEMORYIMAGE_H_
+#define _MEMORYIMAGE_H_
+
+#include "IOpenGLImage.hpp"
+#include "Image.hpp"
+
+/// plain CPU framebuffer for headless rendering. does not need an OpenGL context.
+class MemoryImage : public IOpenGLImage
+{
+private:
+	Image img;
+
+public:
+	MemoryImage(unsigned int width, unsigned int height);
+
+	virtual void setPixel(int x, int y, vec color);
+	virtual vec* operator[](int y);
+	
+	virtual void beginWrite();
+	virtual void endWrite();
+
+	virtual void drawFullscreen();
+	virtual void saveToFile(const char* filename);
+};
+
+#endif
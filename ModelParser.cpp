@@ -167,6 +167,7 @@ void ModelParser::getTranslationAndScaleForUnitCube(float translate[3], float& s
 }
 
 
+#ifndef HEADLESS
 /**
 * \brief Returns the modelmatrix of the model (only one supported)
 */
@@ -238,6 +239,7 @@ void ModelParser::getTranslationMatrix(float matrix[16])
 
 	glPopMatrix();  
 }
+#endif
 
 
 /**
@@ -397,6 +399,7 @@ unsigned long ModelParser::getFaceCount(const string s)
 }
 
 
+#ifndef HEADLESS
 /**
 * \brief Creates an OpenGL display list of the current data
 */
@@ -449,6 +452,7 @@ GLint ModelParser::createDisplayList() const
 
 	return result;
 }
+#endif
 
 
 /**
@@ -16,7 +16,9 @@
 #include <list>
 #include "HashMap.hpp"
 
+#ifndef HEADLESS
 #include <GL/glut.h>
+#endif
 
 //#include <Mesh.h>
 #include "vecmath.h"
@@ -174,13 +176,17 @@ public:
 	vector<int3> getTriangles();
 	void getBoundingBox(vec3& min, vec3& max) const;
 	void getTranslationAndScaleForUnitCube(float translate[3], float& scale) const;
+#ifndef HEADLESS
 	void getModelMatrix(float matrix[16]);
 	void getTranslationMatrix(float matrix[16]);
+#endif
 	//Martin::Mesh getMesh();
 
 	bool  loadFile(const string fileName, const bool useVertexNormals = false);
 	unsigned long getFaceCount(const string fileName);
+#ifndef HEADLESS
 	GLint createDisplayList() const;  
+#endif
 
 protected:
 	// PLY files //
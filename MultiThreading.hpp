@@ -10,11 +10,11 @@
 
 #include <omp.h>
 
-#if 0
-	#define MULTITHREADING
-#endif
+// the number of render threads is set at runtime with omp_set_num_threads (command line argument -threads).
+// per-thread data is allocated for omp_get_max_threads() threads.
 
-#define THREAD_COUNT 128
+/// per-thread data is aligned to cache lines to prevent threads from sharing cache lines
+#define CACHE_LINE_SIZE 64
 
 
 
@@ -0,0 +1,68 @@
+#include <string.h>
+
+#include "NodeAccessTrace.hpp"
+
+static const char NODE_TRACE_MAGIC[8] = { 'S', 'S', 'H', 'N', 'O', 'D', 'E', '1' };
+
+NodeAccessTrace::NodeAccessTrace() : file(NULL), failed(false), used(0)
+{
+	memset(&header, 0, sizeof(header));
+}
+
+NodeAccessTrace::~NodeAccessTrace()
+{
+	close();
+}
+
+bool NodeAccessTrace::open(const char* fileName)
+{
+	close();
+
+	file = fopen(fileName, "wb");
+	if(!file) return false;
+
+	// the layout may have been set before
+	memcpy(header.magic, NODE_TRACE_MAGIC, sizeof(header.magic));
+	header.packetCount = 0;
+	header.entryCount = 0;
+	used = 0;
+
+	// the header is written again with the counts on close
+	failed = fwrite(&header, sizeof(header), 1, file) != 1;
+	return !failed;
+}
+
+void NodeAccessTrace::setLayout(unsigned int nodeSize, unsigned int packedNodeSize, unsigned long nodeCount, unsigned int triangleSize, unsigned long triangleCount)
+{
+	header.nodeSize = nodeSize;
+	header.packedNodeSize = packedNodeSize;
+	header.nodeCount = nodeCount;
+	header.triangleSize = triangleSize;
+	header.triangleCount = triangleCount;
+}
+
+void NodeAccessTrace::flush()
+{
+	if(file && used != 0 && fwrite(buffer, sizeof(uint32_t), used, file) != used) failed = true;
+	header.entryCount += used;
+	used = 0;
+}
+
+bool NodeAccessTrace::close()
+{
+	if(!file) return true;
+
+	flush();
+	if(fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) failed = true;
+	if(fclose(file) != 0) failed = true;
+	file = NULL;
+
+	return !failed;
+}
+
+bool NodeAccessTrace::readHeader(FILE* file, NodeTraceHeader& header)
+{
+	return fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, NODE_TRACE_MAGIC, sizeof(header.magic)) == 0
+		&& header.nodeSize != 0;
+}
@@ -0,0 +1,95 @@
+#ifndef NODEACCESSTRACE_HPP
+#define NODEACCESSTRACE_HPP
+
+#include <stdio.h>
+
+#ifdef WINDOWS
+	typedef unsigned __int32 uint32_t;
+#else
+	#include <stdint.h>
+#endif
+
+// entries buffered before they are written to the file
+#define NODE_TRACE_BUFFER_ENTRIES 65536
+
+/// header of a node access trace file. the entries follow as 32 bit words.
+struct NodeTraceHeader
+{
+	char magic[8];
+	unsigned int nodeSize;	// sizeof(Node) of the writer, i.e. the stride of the node array
+	unsigned int packedNodeSize;	// Node::memSize, the node without padding
+	unsigned int triangleSize;	// sizeof(Triangle) of the writer
+	unsigned int padding;
+	unsigned long nodeCount;
+	unsigned long triangleCount;
+	unsigned long packetCount;
+	unsigned long entryCount;
+};
+
+/*
+	sequence of the nodes and triangles the traversal of each ray packet touches, written to a compact binary file.
+	the cache simulator (cachesim.cpp) replays it with any cache geometry and node size, so node layouts can be
+	compared without the noise of the other threads, the shading and the timer.
+
+	each entry is one 32 bit word: a node index, a triangle index with TRIANGLE_FLAG or END_OF_PACKET after the
+	accesses of a packet. the trace is not synchronized, so the traced packets have to be traversed by one thread.
+*/
+class NodeAccessTrace
+{
+public:
+	enum ENTRY
+	{
+		TRIANGLE_FLAG = 0x80000000u,
+		END_OF_PACKET = 0xFFFFFFFFu,
+		MAX_INDEX = 0x7FFFFFFEu	// largest node or triangle index
+	};
+
+	NodeAccessTrace();
+	~NodeAccessTrace();
+
+	/// creates the file. returns false if it cannot be written.
+	bool open(const char* fileName);
+
+	/// writes the remaining entries and the final header. returns false if the file could not be written.
+	bool close();
+
+	bool isOpen() const { return file != NULL; }
+
+	/// node array and triangle array of the traced scene. set by Scene::setAccessTrace.
+	void setLayout(unsigned int nodeSize, unsigned int packedNodeSize, unsigned long nodeCount, unsigned int triangleSize, unsigned long triangleCount);
+
+	inline void node(unsigned long index) { put((uint32_t)index); }
+	inline void triangle(unsigned long index) { put(TRIANGLE_FLAG | (uint32_t)index); }
+
+	inline void endPacket()
+	{
+		put(END_OF_PACKET);
+		++header.packetCount;
+	}
+
+	unsigned long getPacketCount() const { return header.packetCount; }
+
+	/// reads the header of a trace. returns false if the file is no trace of this build.
+	static bool readHeader(FILE* file, NodeTraceHeader& header);
+
+private:
+	FILE* file;
+	bool failed;	// a write failed
+	NodeTraceHeader header;
+	uint32_t buffer[NODE_TRACE_BUFFER_ENTRIES];
+	unsigned int used;
+
+	inline void put(uint32_t entry)
+	{
+		if(used == NODE_TRACE_BUFFER_ENTRIES) flush();
+		buffer[used++] = entry;
+	}
+
+	void flush();
+
+	// not copyable
+	NodeAccessTrace(const NodeAccessTrace&);
+	NodeAccessTrace& operator=(const NodeAccessTrace&);
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <linux/mempolicy.h>
+#else
+	#include <xmmintrin.h>
+#endif
+
+#include "NumaPlacement.hpp"
+
+#define HUGE_PAGE_SIZE (2ul*1024*1024)
+
+// nodes with a higher id are ignored. the mbind node mask is a single unsigned long.
+#define MAX_NUMA_NODES ((int)sizeof(unsigned long)*8)
+
+NumaPlacement::POLICY NumaPlacement::policy = NumaPlacement::NONE;
+NumaPlacement::HUGE_PAGES NumaPlacement::hugePages = NumaPlacement::NO_HUGE_PAGES;
+int NumaPlacement::nodeCount = 1;
+std::vector<int> NumaPlacement::cpuNodes;
+
+#ifdef __linux__
+/// reads a cpu list like "0-7,16-23" and assigns the cpus to node
+static void readCpuList(FILE* file, int node, std::vector<int>& cpuNodes)
+{
+	int first, last;
+	while(fscanf(file, "%d", &first) == 1)
+	{
+		last = first;
+		int c = fgetc(file);
+		if(c == '-')
+		{
+			if(fscanf(file, "%d", &last) != 1) return;
+			c = fgetc(file);
+		}
+
+		for (int cpu = first; cpu <= last; ++cpu)
+		{
+			if(cpu >= (int)cpuNodes.size()) cpuNodes.resize(cpu+1, 0);
+			cpuNodes[cpu] = node;
+		}
+
+		if(c != ',') return;
+	}
+}
+#endif
+
+void NumaPlacement::init()
+{
+	nodeCount = 1;
+	cpuNodes.clear();
+
+#ifdef __linux__
+	char path[128];
+	for (int node = 0; node < MAX_NUMA_NODES; ++node)
+	{
+		sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+		FILE* file = fopen(path, "r");
+		if(!file) continue;	// node ids may have gaps
+
+		readCpuList(file, node, cpuNodes);
+		fclose(file);
+
+		if(node >= nodeCount) nodeCount = node+1;
+	}
+#endif
+}
+
+int NumaPlacement::getCurrentNode()
+{
+#ifdef __linux__
+	int cpu = sched_getcpu();
+	if(cpu >= 0 && cpu < (int)cpuNodes.size()) return cpuNodes[cpu];
+#endif
+	return 0;
+}
+
+size_t NumaPlacement::roundSize(size_t bytes)
+{
+	size_t pageSize = 4096;
+	if(hugePages != NO_HUGE_PAGES) pageSize = HUGE_PAGE_SIZE;
+	if(bytes == 0) bytes = 1;
+	return (bytes + pageSize - 1) / pageSize * pageSize;
+}
+
+void* NumaPlacement::allocate(size_t bytes, int node)
+{
+	size_t size = roundSize(bytes);
+
+#ifdef __linux__
+	void* memory = MAP_FAILED;
+
+	if(hugePages == EXPLICIT_HUGE_PAGES)
+	{
+		memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+
+	if(memory == MAP_FAILED)
+	{
+		memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(memory == MAP_FAILED) throw std::bad_alloc();
+
+		if(hugePages != NO_HUGE_PAGES) madvise(memory, size, MADV_HUGEPAGE);
+	}
+
+	// the pages are not touched yet, so the policy decides where they are placed on first write.
+	// without NUMA support in the kernel the call fails and first touch decides.
+	if(nodeCount > 1 && (node >= 0 || policy == INTERLEAVE))
+	{
+		unsigned long mask = 0;
+		if(node >= 0)
+		{
+			mask = 1ul << node;
+		}
+		else
+		{
+			for (int i = 0; i < nodeCount; ++i) mask |= 1ul << i;
+		}
+
+		syscall(SYS_mbind, memory, size, node >= 0 ? MPOL_PREFERRED : MPOL_INTERLEAVE, &mask, sizeof(mask)*8 + 1, 0);
+	}
+
+	return memory;
+#else
+	void* memory = _mm_malloc(size, 4096);
+	if(!memory) throw std::bad_alloc();
+	return memory;
+#endif
+}
+
+void NumaPlacement::release(void* memory, size_t bytes)
+{
+	if(!memory) return;
+
+#ifdef __linux__
+	munmap(memory, roundSize(bytes));
+#else
+	_mm_free(memory);
+#endif
+}
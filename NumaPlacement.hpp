@@ -0,0 +1,78 @@
+#ifndef NUMAPLACEMENT_HPP
+#define NUMAPLACEMENT_HPP
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+/*
+	placement of the read-only scene arrays (hierarchy nodes and triangles) on NUMA machines.
+	the arrays are built by a single thread, so by first touch all their pages end up on the memory of one socket.
+	after construction the scenes copy them to memory which is either interleaved over all NUMA nodes or bound to one node
+	per replica. the copies can be backed by transparent or explicit huge pages to reduce TLB misses during traversal.
+	the topology is read from /sys and memory is bound with the mbind system call, so libnuma is not needed.
+	on other systems than linux there is one NUMA node and the copies are plain aligned allocations.
+*/
+class NumaPlacement
+{
+public:
+	enum POLICY
+	{
+		NONE,		// keep the arrays where the builder put them
+		INTERLEAVE,	// one copy with pages interleaved round-robin over all nodes
+		REPLICATE	// one copy per node. each thread reads the copy of the node it runs on
+	};
+
+	enum HUGE_PAGES
+	{
+		NO_HUGE_PAGES,
+		TRANSPARENT_HUGE_PAGES,	// madvise(MADV_HUGEPAGE)
+		EXPLICIT_HUGE_PAGES		// mmap(MAP_HUGETLB). falls back to normal pages if no huge pages are reserved.
+	};
+
+	/// set by command line arguments before the scenes are constructed
+	static POLICY policy;
+	static HUGE_PAGES hugePages;
+
+	/// reads the topology. must be called once before the render threads start.
+	static void init();
+
+	/// true if the scenes should copy their arrays to placed memory
+	static bool enabled() { return policy != NONE || hugePages != NO_HUGE_PAGES; }
+
+	/// number of NUMA nodes. node ids are 0..getNodeCount()-1.
+	static int getNodeCount() { return nodeCount; }
+
+	/// NUMA node of the cpu the calling thread runs on
+	static int getCurrentNode();
+
+	/// allocates untouched memory. the pages are bound to node, or interleaved over all nodes if node is negative
+	/// and the policy is INTERLEAVE.
+	static void* allocate(size_t bytes, int node);
+
+	/// frees memory of allocate. bytes must be the size passed to allocate.
+	static void release(void* memory, size_t bytes);
+
+	/// allocates placed memory for count objects and copies them in parallel
+	template<class T>
+	static T* copy(const T* source, size_t count, int node)
+	{
+		T* target = (T*)allocate(count * sizeof(T), node);
+
+		#pragma omp parallel for schedule(static)
+		for (long i = 0; i < (long)count; ++i)
+		{
+			new (&target[i]) T(source[i]);
+		}
+
+		return target;
+	}
+
+private:
+	static int nodeCount;
+	static std::vector<int> cpuNodes;	// NUMA node of each cpu
+
+	static size_t roundSize(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include <string.h>
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <sys/syscall.h>
+	#include <linux/perf_event.h>
+#endif
+
+#include "PerfCounters.hpp"
+
+PerfCounters::PerfCounters() : leader(-1), slotCount(0)
+{
+	for (int i = 0; i < EVENT_COUNT; ++i)
+	{
+		descriptors[i] = -1;
+		slots[i] = -1;
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	close();
+}
+
+#ifdef __linux__
+static void setEventConfig(int event, struct perf_event_attr& attr)
+{
+	attr.type = PERF_TYPE_HARDWARE;
+	switch(event)
+	{
+	case PerfCounters::CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+	case PerfCounters::INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+	case PerfCounters::LLC_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+	case PerfCounters::BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+	case PerfCounters::L1D_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	}
+}
+#endif
+
+bool PerfCounters::open()
+{
+	close();
+
+#ifdef __linux__
+	for (int event = 0; event < EVENT_COUNT; ++event)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		setEventConfig(event, attr);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+
+		// the first available event leads the group. the members follow it.
+		int descriptor = (int)syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+		if(descriptor < 0) continue;
+
+		if(leader < 0) leader = descriptor;
+		descriptors[event] = descriptor;
+		slots[event] = slotCount++;
+	}
+#endif
+
+	return isOpen();
+}
+
+void PerfCounters::close()
+{
+#ifdef __linux__
+	// members before the leader
+	for (int i = EVENT_COUNT-1; i >= 0; --i)
+	{
+		if(descriptors[i] >= 0 && descriptors[i] != leader) ::close(descriptors[i]);
+	}
+	if(leader >= 0) ::close(leader);
+#endif
+
+	leader = -1;
+	slotCount = 0;
+	for (int i = 0; i < EVENT_COUNT; ++i)
+	{
+		descriptors[i] = -1;
+		slots[i] = -1;
+	}
+}
+
+void PerfCounters::read(uint64_t* counts) const
+{
+	for (int i = 0; i < EVENT_COUNT; ++i) counts[i] = 0;
+
+#ifdef __linux__
+	if(leader < 0) return;
+
+	// PERF_FORMAT_GROUP: number of events followed by their values
+	uint64_t values[1 + EVENT_COUNT];
+	if(::read(leader, values, sizeof(uint64_t) * (1 + slotCount)) <= 0) return;
+
+	for (int i = 0; i < EVENT_COUNT; ++i)
+	{
+		if(slots[i] >= 0) counts[i] = values[1 + slots[i]];
+	}
+#endif
+}
+
+const char* PerfCounters::getEventName(int event)
+{
+	static const char* names[EVENT_COUNT] = { "cycles", "instructions", "L1D misses", "LLC misses", "branch misses" };
+	return names[event];
+}
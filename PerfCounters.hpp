@@ -0,0 +1,56 @@
+#ifndef PERFCOUNTERS_HPP
+#define PERFCOUNTERS_HPP
+
+#ifdef WINDOWS
+	typedef unsigned __int64 uint64_t;
+#else
+	#include <stdint.h>
+#endif
+
+/*
+	hardware event counters of one thread (linux perf_event_open). the events are opened as one group, so a read
+	returns the counts of all events at the same instant. events the cpu, the kernel or the permissions
+	(/proc/sys/kernel/perf_event_paranoid) do not provide stay unavailable and read 0.
+	only user space events are counted. other platforms have no counters.
+*/
+class PerfCounters
+{
+public:
+	enum EVENT
+	{
+		CYCLES,
+		INSTRUCTIONS,
+		L1D_MISSES,	// level 1 data cache read misses
+		LLC_MISSES,	// last level cache misses
+		BRANCH_MISSES,
+		EVENT_COUNT
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	/// opens the counters of the calling thread. returns false if no event is available.
+	/// the counts can be read by any thread afterwards.
+	bool open();
+	void close();
+
+	bool isOpen() const { return leader >= 0; }
+	bool isAvailable(int event) const { return slots[event] >= 0; }
+
+	/// current counts since open. unavailable events are 0.
+	void read(uint64_t* counts) const;
+
+	static const char* getEventName(int event);
+
+private:
+	int leader;	// file descriptor of the group leader. -1 if closed.
+	int descriptors[EVENT_COUNT];
+	int slots[EVENT_COUNT];	// position of the event in a group read. -1 if unavailable.
+	int slotCount;
+
+	// not copyable
+	PerfCounters(const PerfCounters&);
+	PerfCounters& operator=(const PerfCounters&);
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef RAYARENA_HPP
+#define RAYARENA_HPP
+
+#include <vector>
+#include <cassert>
+
+/*
+	frame-lifetime storage for ray records.
+	records are constructed in chunks of CHUNK_SIZE, so their addresses stay valid while more records are added.
+	clear() resets the arena in bulk and keeps the chunks for the next bounce level, so after the first frames no memory is allocated at all.
+	each thread owns its own arenas, so there is no allocator contention between threads.
+	T has to inherit from SIMDmemAligned if it contains SIMD types.
+*/
+template <class T, unsigned int CHUNK_SIZE = 1024>
+class RayArena
+{
+public:
+	RayArena() : count(0)
+	{
+	}
+
+	~RayArena()
+	{
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			delete[] chunks[i];
+		}
+	}
+
+	/// returns a new record at the end of the arena. the record contains the values of a previously cleared record.
+	inline T& push()
+	{
+		if(count == chunks.size() * CHUNK_SIZE)
+		{
+			chunks.push_back(new T[CHUNK_SIZE]);
+		}
+		T& record = chunks[count / CHUNK_SIZE][count % CHUNK_SIZE];
+		++count;
+		return record;
+	}
+
+	inline T& operator[](size_t index)
+	{
+		assert(index < count);
+		return chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+	}
+
+	inline size_t size() const
+	{
+		return count;
+	}
+
+	inline bool empty() const
+	{
+		return count == 0;
+	}
+
+	/// removes the records behind the first count records
+	inline void truncate(size_t count)
+	{
+		assert(count <= this->count);
+		this->count = count;
+	}
+
+	/// removes all records but keeps the memory
+	inline void clear()
+	{
+		count = 0;
+	}
+
+private:
+	std::vector<T*> chunks;
+	size_t count;
+
+	// not copyable
+	RayArena(const RayArena&);
+	RayArena& operator=(const RayArena&);
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "RayQueueSorter.hpp"
+
+// origin cells per axis are 2^CELL_BITS
+#define CELL_BITS 7
+
+/// inserts two zero bits between each of the lowest CELL_BITS bits
+static unsigned long spreadBits(unsigned long v)
+{
+	unsigned long result = 0;
+	for (int i = 0; i < CELL_BITS; ++i)
+	{
+		result |= ((v >> i) & 1ul) << (3*i);
+	}
+	return result;
+}
+
+RayQueueSorter::RayQueueSorter() : cellScale(0.0f)
+{
+}
+
+void RayQueueSorter::setBounds(const AABBox& bounds)
+{
+	this->bounds = bounds;
+
+	vec extend = bounds.max - bounds.min;
+	float cells = float(1 << CELL_BITS);
+	cellScale = vec(
+		extend.x > 0.0f ? cells / extend.x : 0.0f,
+		extend.y > 0.0f ? cells / extend.y : 0.0f,
+		extend.z > 0.0f ? cells / extend.z : 0.0f);
+}
+
+unsigned long RayQueueSorter::getKey(const vec& origin, const vec& dir, int level) const
+{
+	const long maxCell = (1 << CELL_BITS) - 1;
+
+	unsigned long morton = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		long cell = long((origin[axis] - bounds.min[axis]) * cellScale[axis]);
+		cell = cell < 0 ? 0 : (cell > maxCell ? maxCell : cell);
+		morton |= spreadBits(cell) << axis;
+	}
+
+	unsigned long octant = (dir.x < 0.0f ? 1 : 0) | (dir.y < 0.0f ? 2 : 0) | (dir.z < 0.0f ? 4 : 0);
+
+	return ((unsigned long)level << (3*CELL_BITS + 3)) | (octant << (3*CELL_BITS)) | morton;
+}
+
+void RayQueueSorter::packLanes(const Lane* lanes, unsigned int count, PackedRay& ray, qvec& color, quad<vec*>& destination)
+{
+	assert(count > 0 && count <= 4);
+
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		const Lane& lane = lanes[i < count ? i : 0];
+
+		ray.origin.x[i] = lane.origin.x;
+		ray.origin.y[i] = lane.origin.y;
+		ray.origin.z[i] = lane.origin.z;
+		ray.dir.x[i] = lane.dir.x;
+		ray.dir.y[i] = lane.dir.y;
+		ray.dir.z[i] = lane.dir.z;
+		ray.t[i] = lane.t;
+		color.x[i] = lane.color.x;
+		color.y[i] = lane.color.y;
+		color.z[i] = lane.color.z;
+		destination[i] = i < count ? lane.destination : NULL;
+	}
+
+	ray.dirrcp = qvec(qfloat(1.0f)) / ray.dir;
+	ray.hit = NULL;
+}
+
+void RayQueueSorter::sortAndRepack(RayArena<ShadowRay>& rays)
+{
+	if(rays.size() < 2) return;
+
+	std::vector<Lane> lanes;
+
+	// full packets are coherent already and stay as they are. they are moved to the front of the queue.
+	// the lanes of partial packets are collected and repacked behind them.
+	size_t packets = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		ShadowRay& sray = rays[i];
+		if(sray.destination[0] && sray.destination[1] && sray.destination[2] && sray.destination[3])
+		{
+			if(packets != i) rays[packets] = sray;
+			++packets;
+			continue;
+		}
+
+		for (int l = 0; l < 4; ++l)
+		{
+			if(!sray.destination[l]) continue;
+
+			Lane lane;
+			lane.origin = vec(sray.ray.origin.x[l], sray.ray.origin.y[l], sray.ray.origin.z[l]);
+			lane.dir = vec(sray.ray.dir.x[l], sray.ray.dir.y[l], sray.ray.dir.z[l]);
+			lane.t = sray.ray.t[l];
+			lane.color = vec(sray.color.x[l], sray.color.y[l], sray.color.z[l]);
+			lane.destination = sray.destination[l];
+			lane.level = 0;
+			lane.key = getKey(lane.origin, lane.dir, 0);
+			lanes.push_back(lane);
+		}
+	}
+
+	std::sort(lanes.begin(), lanes.end());
+
+	rays.truncate(packets);
+	for (size_t i = 0; i < lanes.size(); i += 4)
+	{
+		unsigned int count = lanes.size() - i < 4 ? lanes.size() - i : 4;
+
+		ShadowRay& sray = rays.push();
+		packLanes(&lanes[i], count, sray.ray, sray.color, sray.destination);
+	}
+}
+
+void RayQueueSorter::sortAndRepack(RayArena<RefxxctionRay>& rays)
+{
+	if(rays.size() < 2) return;
+
+	std::vector<Lane> lanes;
+
+	// full packets are coherent already and stay as they are. they are moved to the front of the queue.
+	// the lanes of partial packets are collected and repacked behind them.
+	size_t packets = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		RefxxctionRay& sray = rays[i];
+		if(sray.destination[0] && sray.destination[1] && sray.destination[2] && sray.destination[3])
+		{
+			if(packets != i) rays[packets] = sray;
+			++packets;
+			continue;
+		}
+
+		for (int l = 0; l < 4; ++l)
+		{
+			if(!sray.destination[l]) continue;
+
+			Lane lane;
+			lane.origin = vec(sray.ray.origin.x[l], sray.ray.origin.y[l], sray.ray.origin.z[l]);
+			lane.dir = vec(sray.ray.dir.x[l], sray.ray.dir.y[l], sray.ray.dir.z[l]);
+			lane.t = sray.ray.t[l];
+			lane.color = vec(sray.contribution.x[l], sray.contribution.y[l], sray.contribution.z[l]);
+			lane.destination = sray.destination[l];
+			lane.level = sray.level;
+			lane.key = getKey(lane.origin, lane.dir, sray.level);
+			lanes.push_back(lane);
+		}
+	}
+
+	std::sort(lanes.begin(), lanes.end());
+
+	rays.truncate(packets);
+	size_t i = 0;
+	while (i < lanes.size())
+	{
+		// a packet holds lanes of one level only
+		unsigned int count = 1;
+		while(count < 4 && i+count < lanes.size() && lanes[i+count].level == lanes[i].level) ++count;
+
+		RefxxctionRay& sray = rays.push();
+		sray.level = lanes[i].level;
+		sray.repacked = true;
+		packLanes(&lanes[i], count, sray.ray, sray.contribution, sray.destination);
+
+		i += count;
+	}
+}
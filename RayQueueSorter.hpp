@@ -0,0 +1,54 @@
+#ifndef RAYQUEUESORTER_HPP
+#define RAYQUEUESORTER_HPP
+
+#include <vector>
+
+#include "vecmath.h"
+#include "AABBox.hpp"
+#include "ShadowRay.hpp"
+#include "RefxxctionRay.hpp"
+#include "RayArena.hpp"
+
+/*
+	sorts the lanes of partially filled secondary ray packets by direction octant and origin cell and repacks them into full 4-wide packets.
+	coherent packets visit fewer nodes per ray and use all SIMD lanes, while the queues mostly hold single-lane packets otherwise.
+	the destination pointers travel with the lanes, so the shading results are scattered back to the right pixels.
+	full packets are not split since they are coherent already.
+*/
+class RayQueueSorter
+{
+public:
+	RayQueueSorter();
+
+	/// origin cells are computed from the scene bounds
+	void setBounds(const AABBox& bounds);
+
+	void sortAndRepack(RayArena<ShadowRay>& rays);
+	void sortAndRepack(RayArena<RefxxctionRay>& rays);
+
+private:
+	// one active lane of a queued packet
+	struct Lane
+	{
+		unsigned long key;
+		vec origin;
+		vec dir;
+		float t;
+		vec color;	// light contribution of shadow rays or contribution of reflection/refraction rays
+		vec* destination;
+		int level;
+
+		bool operator<(const Lane& other) const { return key < other.key; }
+	};
+
+	AABBox bounds;
+	vec cellScale;
+
+	/// sort key: level, direction octant, morton code of origin cell
+	unsigned long getKey(const vec& origin, const vec& dir, int level) const;
+
+	/// writes up to 4 lanes into a packet. unused lanes repeat the first lane and get a NULL destination.
+	static void packLanes(const Lane* lanes, unsigned int count, PackedRay& ray, qvec& color, quad<vec*>& destination);
+};
+
+#endif
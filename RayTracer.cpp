@@ -10,8 +10,12 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <string.h>
 #include <assert.h>
+#ifndef WINDOWS
+	#include <sys/resource.h>
+#endif
 
 #include "MultiThreading.hpp"
 
@@ -45,11 +49,13 @@
 #include "DiscLight.hpp"
 #include "QuadLight.hpp"
 
-#include "OpenGLTexture.hpp"
-#include "OpenGLDrawPixels.hpp"
-#include "PBO.hpp"
-
-#include "TestConfig.hpp"
+#ifndef HEADLESS
+	#include "OpenGLTexture.hpp"
+	#include "OpenGLDrawPixels.hpp"
+	#include "PBO.hpp"
+#endif
+#include "MemoryImage.hpp"
+#include "NumaPlacement.hpp"
 
 #include "SimpleScene.hpp" // debug threads
 
@@ -60,6 +66,14 @@ using namespace std;
 /// max number of reflections & refractions per primary ray
 #define LEVELS 8
 #define SKYBOX_SIZE 2000
+/// primary ray packets of the probe frame of the automatic method selection. spread over the image.
+#define AUTO_PROBE_PACKETS 4096
+/// probes per candidate. the fastest one is taken.
+#define AUTO_PROBE_REPEAT 3
+/// models up to this size are probed without acceleration structure as well
+#define AUTO_SIMPLE_MAX_TRIANGLES 256
+/// frames the automatic method selection expects in interactive mode
+#define AUTO_INTERACTIVE_FRAMES 100
 
 Material* skyboxMaterial;
 
@@ -96,16 +110,36 @@ int getFirstModelArgument(int argc, char** argv)
 	return -1;
 }
 
+/// splits a comma separated command line argument
+void splitList(const char* list, std::vector<std::string>& result)
+{
+	std::string text(list);
+	size_t begin = 0;
+	while(begin <= text.size())
+	{
+		size_t comma = text.find(',', begin);
+		if(comma == std::string::npos) comma = text.size();
+		if(comma > begin) result.push_back(text.substr(begin, comma - begin));
+		begin = comma + 1;
+	}
+}
+
 void printUsageAndExit()
 {
 	std::cout << "\n\nUsage:\n"
-		<< "./simdtrace [-mode=<mode>] [-cameraMode=<cameraMode>] [-frames=<frames>] [-methods=<methods>] [-displayMethod=<displaymethod>] [-resolution=<resolution>] [-shadows=0|1] [-light=1|2|3|3] [-ignoreMaterials] [-nostats] <models> [<models>]...\n\n"
+		<< "./simdtrace [-mode=<mode>] [-cameraMode=<cameraMode>] [-frames=<frames>] [-methods=<methods>] [-memoryBudget=<MB>] [-displayMethod=<displaymethod>] [-resolution=<resolution>] [-headless] [-shadows=0|1] [-sortRays=0|1] [-threads=<threads>] [-tileSize=<tileSize>] [-secondary=T|F] [-pipeline] [-heatmap=N|T] [-recordRays=<file>] [-trace=<file>] [-metrics=<name>] [-perfCounters] [-numa=N|I|R] [-hugePages=N|T|E] [-light=1|2|3|3] [-ignoreMaterials] [-nostats] [-cameras=<cameras>] [-warmup=<frames>] [-repeat=<frames>] [-benchmarkFile=<file>] [-baseline=<file>] [-tolerance=<percent>] [-threadSweep] <models> [<models>]...\n\n"
 		<< "methods:\n"
 		<< "K: KD Tree\n"
 		<< "V: BVH - Bounding Volume Hierarchy\n"
 		<< "S: SSH - Single Slab Hierarchy\n"
+		<< "D: DSH - Dual Slab Hierarchy. SSH with two planes per node\n"
+		<< "H: Hybrid - SSH whose upper nodes have boxes as far as they pay off and fit into the memory budget\n"
 		<< "N: No acceleration method\n"
+		<< "A: Automatic. builds SSH, BVH, DSH and hybrid (and no acceleration for small models), traces a probe of the primary rays\n"
+		<< " with each and keeps the one with the lowest construction and traversal time for the frames of the mode.\n"
 		<< "you can set multiple methods for test mode. e.g. -methods=SV\n\n"
+		<< "memoryBudget: largest acceleration structure in MB the automatic method selection may choose\n"
+		<< " and size of the hybrid hierarchy (default: no limit)\n\n"
 		<< "camera modes:\n"
 		<< "T: Trackball\n"
 		<< "other or none: First person camera\n\n"
@@ -114,6 +148,8 @@ void printUsageAndExit()
 		<< "T: glTexture2D (default)\n"
 		<< "D: glDrawPixels\n\n"
 		<< "resolution is given as WIDTHxHEIGHT, e.g. 800x600\n\n"
+		<< "headless: render without window and OpenGL into a memory image. requires mode T or V.\n"
+		<< " builds with HEADLESS=1 are always headless.\n\n"
 		<< "model is the name of a model file, e.g. barney.obj.\n"
 		<< "file extension must be obj or ply.\n"
 		<< "you can run test with different model files by separating them with a \" \".\n"
@@ -123,8 +159,20 @@ void printUsageAndExit()
 		<< "mode:\n"
 		<< "T: test mode\n"
 		<< "I: interactive mode\n"
-		<< "V: video mode. saves a series of images of the given models to disk.\n\n"
+		<< "V: video mode. saves a series of images of the given models to disk.\n"
+		<< "B: benchmark mode. renders each combination of model, method, camera, resolution and thread count headless\n"
+		<< " and writes frame time statistics as JSON to testresults/benchmark.json.\n"
+		<< " -resolution and -threads take comma separated lists, e.g. -resolution=320x240,640x480 -threads=1,2,4\n"
+		<< " cameras: comma separated camera files (see key o). default: cameras/<model>.camera or the scene bounds\n"
+		<< " warmup: frames rendered before the measurement (default 2). repeat: measured frames (default 10)\n"
+		<< " benchmarkFile: JSON output file\n"
+		<< " baseline: JSON output file of an earlier benchmark to compare with. the exit code is 2 if the median frame time,\n"
+		<< " the traversal time, the construction time or the memory of a configuration is more than tolerance percent\n"
+		<< " (default 10) above the baseline. see \"regression gate.sh\"\n\n"
 		<< "frames: number of frames per test run. used in test mode only.\n\n"
+		<< "threadSweep: test mode constructs and renders each model and method headless with 1, 2, 4, ... threads up to the\n"
+		<< " thread count and prints speedup, efficiency and rays per second per core of construction and rendering.\n"
+		<< " the table is added to testresults/scaling.txt. the frame time is the median of the frames per test run.\n\n"
 		<< "light: 1-6\n"
 		<< " 1: far point light\n"
 		<< " 2: white light front, colored light background\n"
@@ -132,6 +180,31 @@ void printUsageAndExit()
 		<< " 4: visualize surface normals\n"
 		<< " 5: random sampled disc light\n"
 		<< " 6: uniform sampled quad light\n\n"
+		<< "threads: number of render threads (default: number of processors).\n"
+		<< " traversal time and intersection counts are measured with 1 thread only.\n\n"
+		<< "tileSize: edge length of the image tiles which are distributed among the threads. multiple of 2 (default 16)\n\n"
+		<< "secondary: T traces the secondary rays of a tile by the thread which traced the tile (default).\n"
+		<< " F traces the secondary rays of the whole frame level by level shared among all threads.\n\n"
+		<< "pipeline: trace the next frame while the previous frame is displayed. the display lags one frame behind\n"
+		<< " but the upload to the graphics card does not add to the frame time.\n\n"
+		<< "heatmap: show the traversal cost of the primary rays as false colour image instead of the shaded image.\n"
+		<< " N: node visits, T: triangle tests. blue is cheap, red is the maximum of the frame. black rays miss the scene.\n"
+		<< " counted by the hierarchies only. video mode saves images/<model>.nodes.ppm or images/<model>.triangles.ppm\n\n"
+		<< "recordRays: write the triangles and all ray packets traced in the first frame to a file. the rays can be traced\n"
+		<< " again without shading by ./rayreplay <file> (make rayreplay) to compare the speed and hits of the methods.\n\n"
+		<< "trace: write a timeline of loading, construction, frames, tiles, secondary ray levels and display per thread\n"
+		<< " to a file when the program exits. open it with chrome://tracing or ui.perfetto.dev.\n\n"
+		<< "metrics: publish frame rate, rays per second, stage times, node and triangle tests and memory of each frame\n"
+		<< " to the shared memory segment <name>, e.g. /simdtrace (linux only). read them with ./livemetrics <name> (make livemetrics).\n\n"
+		<< "perfCounters: count cycles, instructions, L1D misses, LLC misses and branch misses per thread and render stage\n"
+		<< " with perf_event_open (linux only) and print them with the test results. needs the measurements (no -nostats)\n"
+		<< " and costs a counter read per stage switch. see /proc/sys/kernel/perf_event_paranoid if they are not available.\n\n"
+		<< "numa: placement of the hierarchy nodes and triangles on NUMA machines\n"
+		<< " N: keep them on the node of the building thread (default)\n"
+		<< " I: interleave the pages over all nodes\n"
+		<< " R: one copy per node. threads read the copy of their node and steal tiles from threads of their node first.\n\n"
+		<< "hugePages: N: normal pages (default), T: transparent huge pages, E: explicit huge pages (needs reserved pages)\n\n"
+		<< "sortRays: sort and repack the secondary ray queues before each pass (default 1)\n\n"
 		<< "ignoreMaterials: relpace materials by white eyelight shader\n\n"
 		<< "noStats: disable measurements for test results\n\n"
 		<< "keys:\n"
@@ -139,6 +212,7 @@ void printUsageAndExit()
 		<< " i: load camera position\n"
 		<< " o: save camera position\n"
 		<< " b: turn on colored background\n"
+		<< " h: switch between shaded image, node visit heatmap and triangle test heatmap\n"
 		<< " p: save image to file\n\n";
 	exit(1);
 }
@@ -146,12 +220,27 @@ void printUsageAndExit()
 RayTracer::RayTracer()
 {
 	openglImage = 0;
+	headless = false;
+	threads = 1;
 	width = 1;
 	height = 1;
 	camera = 0;
+	frameCamera = 0;
+	pipeline = false;
+	countEvents = false;
+	frameBuffers[0] = 0;
+	frameBuffers[1] = 0;
+	backBuffer = 0;
+	frontBufferValid = false;
+	renderTarget = 0;
+	heatmap = NO_HEATMAP;
+	heatmapMaximum = 0;
+	rayRecorder = 0;
 	cameraSpeed = 0.1f;
 	scene = 0;
 	currentMethod = 0;
+	sceneType = SSH;
+	memoryBudget = 0;
 	mode = RayTracer::TEST;
 	background = false;
 	frameCounter = 0;
@@ -161,6 +250,11 @@ RayTracer::RayTracer()
 	modelFileCount = 0;
 	modelFiles = NULL;
 	makeStats = true;
+	benchmarkWarmup = 2;
+	benchmarkRepeat = 10;
+	benchmarkFile = "testresults/benchmark.json";
+	benchmarkTolerance = 0.1;
+	threadSweep = false;
 }
 
 RayTracer& RayTracer::getInstance()
@@ -189,7 +283,32 @@ void RayTracer::run ( int argc, char** argv, unsigned int width, unsigned int he
 
 	init(argc, argv);
 
+	if(mode == BENCHMARK)
+	{
+		runBenchmark();
+		shutdown();
+		return;
+	}
+
+	if(threadSweep)
+	{
+		runThreadSweep();
+		shutdown();
+		return;
+	}
+
+	if(headless)
+	{
+		// there are no glut callbacks, so the frames are rendered here. test mode and video mode exit after the last model file.
+		while(true)
+		{
+			render();
+		}
+	}
+
+#ifndef HEADLESS
 	glutMainLoop();
+#endif
 
 	shutdown();
 }
@@ -198,13 +317,17 @@ void RayTracer::run ( int argc, char** argv, unsigned int width, unsigned int he
 void RayTracer::idle()
 {
 	// render new frame
+#ifndef HEADLESS
 	glutPostRedisplay();
+#endif
 }
 
+#ifndef HEADLESS
 void RayTracer::changeSizeCallback(GLsizei w, GLsizei h)
 {
 	RayTracer::getInstance().changeSize(w,h);
 }
+#endif
 
 void RayTracer::idleCallback()
 {
@@ -231,6 +354,7 @@ void RayTracer::renderCallback()
 	RayTracer::getInstance().render();
 }
 
+#ifndef HEADLESS
 /// initializes OpenGL
 void RayTracer::initGL(int argc, char** argv)
 {
@@ -261,10 +385,19 @@ void RayTracer::initGL(int argc, char** argv)
 
 	glEnable(GL_TEXTURE_2D);
 }
+#endif
 
 /// creates result image and on-screen output method
 void RayTracer::createImage(int argc, char** argv)
 {
+	if(headless)
+	{
+		cout<<"memory image chosen"<<endl;
+		openglImage = new MemoryImage(width, height);
+		return;
+	}
+
+#ifndef HEADLESS
 	const char* arg = getArgument(argc, argv, "-displayMethod");
 
 	if(arg)
@@ -303,6 +436,7 @@ void RayTracer::createImage(int argc, char** argv)
 		cout<<"glTexture2D chosen"<<endl;
 		openglImage = new OpenGLTexture(width, height);
 	}
+#endif
 }
 
 /// initializes the window and the scene
@@ -314,7 +448,19 @@ void RayTracer::init(int argc, char** argv)
 		printUsageAndExit();
 	}
 
-	initGL(argc, argv);
+	// render without window?
+#ifdef HEADLESS
+	headless = true;
+#else
+	// benchmarks and thread sweeps run without window, too
+	const char* benchmarkarg = getArgument(argc, argv, "-mode");
+	headless = getArgument(argc, argv, "-headless") != NULL || (benchmarkarg && benchmarkarg[0] == 'B') || getArgument(argc, argv, "-threadSweep") != NULL;
+
+	if(!headless)
+	{
+		initGL(argc, argv);
+	}
+#endif
 
 	createImage(argc, argv);
 
@@ -346,6 +492,7 @@ void RayTracer::init(int argc, char** argv)
 
 	vec dir = cameraController.getDir(); normalize(dir);
 	camera = new Camera(width, height, 60.0f, cameraController.getPosition(), dir, vec(0.0f, 1.0f, 0.0f));
+	frameCamera = new Camera(*camera);
 
 	// test material
 	skyboxMaterial = new SkyboxMaterial();
@@ -368,9 +515,18 @@ void RayTracer::init(int argc, char** argv)
 			case 'S':
 				methods.push_back(SSH);
 			break;
+			case 'D':
+				methods.push_back(DSH);
+			break;
+			case 'H':
+				methods.push_back(HYBRID);
+			break;
 			case 'N':
 				methods.push_back(SIMPLE);
 			break;
+			case 'A':
+				methods.push_back(AUTO);
+			break;
 			default:
 				std::cout << "unknown acceleration method: " << arg[i] << endl;
 				exit(-1);
@@ -382,6 +538,10 @@ void RayTracer::init(int argc, char** argv)
 		methods.push_back(SSH);
 	}
 
+	// memory limit of the automatic method selection
+	const char* budgetarg = getArgument(argc, argv, "-memoryBudget");
+	if(budgetarg) memoryBudget = (unsigned long)MAX(0.0, atof(budgetarg) * 1024 * 1024);
+
 	// test mode or interactive mode?
 	const char* moarg = getArgument(argc, argv, "-mode");
 	if(moarg)
@@ -391,6 +551,7 @@ void RayTracer::init(int argc, char** argv)
 		case 'T': mode = TEST; break;
 		case 'I': mode = INTERACTIVE; break;
 		case 'V': mode = VIDEO; break;
+		case 'B': mode = BENCHMARK; break;
 		}
 	}
 	else
@@ -398,6 +559,12 @@ void RayTracer::init(int argc, char** argv)
 		mode = INTERACTIVE;
 	}
 
+	if(headless && mode == INTERACTIVE)
+	{
+		std::cout << "headless rendering supports test mode and video mode only. use -mode=T or -mode=V" << endl;
+		exit(-1);
+	}
+
 	// multiple frames per test
 	const char* farg = getArgument(argc, argv, "-frames");
 	if(farg)
@@ -413,11 +580,152 @@ void RayTracer::init(int argc, char** argv)
 		shadows = atoi(sarg) > 0;
 	}
 
+	// secondary ray sorting enabled
+	sortSecondaryRays = true;
+	const char* sortarg = getArgument(argc, argv, "-sortRays");
+	if(sortarg)
+	{
+		sortSecondaryRays = atoi(sortarg) > 0;
+	}
+
+	// render threads
+	threads = omp_get_num_procs();
+	const char* threadarg = getArgument(argc, argv, "-threads");
+	if(threadarg)
+	{
+		threads = atoi(threadarg);
+		if(threads < 1)
+		{
+			std::cout << "thread count must be at least 1" << endl;
+			exit(-1);
+		}
+	}
+
+	if(mode == BENCHMARK)
+	{
+		parseBenchmarkArguments(argc, argv);
+	}
+
+	// the sweep goes up to the thread count
+	threadSweep = mode == TEST && getArgument(argc, argv, "-threadSweep") != NULL;
+
+	// the scenes allocate their traversal stacks for this number of threads
+	omp_set_num_threads(threads);
+	testSetup.threads = threads;
+
+	// placement of the scene data on NUMA machines
+	NumaPlacement::init();
+	const char* numaarg = getArgument(argc, argv, "-numa");
+	if(numaarg)
+	{
+		switch(numaarg[0])
+		{
+		case 'N': NumaPlacement::policy = NumaPlacement::NONE; break;
+		case 'I': NumaPlacement::policy = NumaPlacement::INTERLEAVE; break;
+		case 'R': NumaPlacement::policy = NumaPlacement::REPLICATE; break;
+		default:
+			std::cout << "unknown NUMA policy: " << numaarg << endl;
+			exit(-1);
+		}
+	}
+	const char* hugearg = getArgument(argc, argv, "-hugePages");
+	if(hugearg)
+	{
+		switch(hugearg[0])
+		{
+		case 'N': NumaPlacement::hugePages = NumaPlacement::NO_HUGE_PAGES; break;
+		case 'T': NumaPlacement::hugePages = NumaPlacement::TRANSPARENT_HUGE_PAGES; break;
+		case 'E': NumaPlacement::hugePages = NumaPlacement::EXPLICIT_HUGE_PAGES; break;
+		default:
+			std::cout << "unknown huge page mode: " << hugearg << endl;
+			exit(-1);
+		}
+	}
+	if(NumaPlacement::policy != NumaPlacement::NONE)
+	{
+		cout << NumaPlacement::getNodeCount() << " NUMA node(s)" << endl;
+	}
+
+	// tile size for the render threads
+	tileSize = 16;
+	const char* tilearg = getArgument(argc, argv, "-tileSize");
+	if(tilearg)
+	{
+		tileSize = atoi(tilearg);
+		if(tileSize < 2 || tileSize % 2 != 0)
+		{
+			std::cout << "tile size must be a positive multiple of 2" << endl;
+			exit(-1);
+		}
+	}
+
+	// secondary rays per tile or per frame
+	globalSecondaryPasses = false;
+	const char* secarg = getArgument(argc, argv, "-secondary");
+	if(secarg)
+	{
+		switch(secarg[0])
+		{
+		case 'T': globalSecondaryPasses = false; break;
+		case 'F': globalSecondaryPasses = true; break;
+		default:
+			std::cout << "unknown secondary ray mode: " << secarg << endl;
+			exit(-1);
+		}
+	}
+
+	// trace the next frame while the previous one is displayed
+	pipeline = getArgument(argc, argv, "-pipeline") != NULL;
+	if(pipeline)
+	{
+		frameBuffers[0] = new MemoryImage(width, height);
+		frameBuffers[1] = new MemoryImage(width, height);
+	}
+	renderTarget = openglImage;
+
+	// traversal cost heatmap
+	heatmap = NO_HEATMAP;
+	const char* heatarg = getArgument(argc, argv, "-heatmap");
+	if(heatarg)
+	{
+		switch(heatarg[0])
+		{
+		case 'N': heatmap = NODE_HEATMAP; break;
+		case 'T': heatmap = TRIANGLE_HEATMAP; break;
+		default:
+			std::cout << "unknown heatmap: " << heatarg << endl;
+			exit(-1);
+		}
+	}
+
+	// ray dump of the first frame
+	const char* recordarg = getArgument(argc, argv, "-recordRays");
+	if(recordarg) rayRecordFile = recordarg;
+
+	// timeline of the threads
+	const char* tracearg = getArgument(argc, argv, "-trace");
+	if(tracearg && tracearg[0])
+	{
+		trace.enable(tracearg);
+		atexit(writeTrace);
+	}
+
+	// live metrics for monitoring processes
+	const char* metricsarg = getArgument(argc, argv, "-metrics");
+	if(metricsarg && metricsarg[0])
+	{
+		if(liveMetrics.open(metricsarg)) std::cout << "publishing metrics to shared memory " << metricsarg << endl;
+		else std::cout << "could not create shared memory " << metricsarg << " for the metrics" << endl;
+	}
+
 	// materials disabled
 	ignoreMaterials = getArgument(argc, argv, "-ignoreMaterials") != NULL;
 
 	// measurements enabled
-	makeStats = getArgument(argc, argv, "-nostats") == NULL;
+	makeStats = getArgument(argc, argv, "-nostats") == NULL || mode == BENCHMARK || threadSweep;
+
+	// hardware event counters. they are charged to the stages of the stage timers, which are measurements.
+	countEvents = getArgument(argc, argv, "-perfCounters") != NULL && makeStats;
 
 	// shadows enabled
 	const char* larg = getArgument(argc, argv, "-light");
@@ -481,21 +789,10 @@ void RayTracer::init(int argc, char** argv)
 	currentModelFile = 0;
 	if(currentModelFile == -1) printUsageAndExit();
 
-	#ifdef MULTITHREADING
-		for (int thread = 0; thread < THREAD_COUNT; ++thread)
-		{
-			refxxctionRaysA[thread].reserve(width*height);
-			refxxctionRaysB[thread].reserve(width*height);
-			refxxctionRays[thread] = &refxxctionRaysA[thread];
-		}
-	#else
-		refxxctionRaysA.reserve(width*height);
-		refxxctionRaysB.reserve(width*height);
-		refxxctionRays = &refxxctionRaysA;
-	#endif
+	createThreadContexts();
 
-	// start first test
-	prepareRaytracing();
+	// start first test. the benchmark and the thread sweep prepare their configurations themselves.
+	if(mode != BENCHMARK && !threadSweep) prepareRaytracing();
 }
 
 const char* getMethodStr(SCENE_TYPE type)
@@ -505,7 +802,10 @@ const char* getMethodStr(SCENE_TYPE type)
 		case KD: return "kd-tree";
 		case BVH: return "BVH";
 		case SSH: return "SSH";
+		case DSH: return "DSH";
+		case HYBRID: return "hybrid";
 		case SIMPLE: return "none";
+		case AUTO: return "auto";
 		default: return "unknown";
 	}
 }
@@ -634,6 +934,8 @@ void RayTracer::prepareRaytracing()
 {
 	if(currentModelFile != previousModelFile)
 	{
+		TraceScope loadScope(trace.getBuffer(omp_get_thread_num()), "load models");
+
 		// delete old materials
 		for(size_t i = 0; i < materials.size(); ++i)
 		{
@@ -736,7 +1038,10 @@ void RayTracer::prepareRaytracing()
 			if(modelFile.find(".obj") != string::npos)
 			{
 				ModelParser mp;
-				mp.loadFile(modelFile.c_str(), true);
+				{
+					TraceScope parseScope(trace.getBuffer(omp_get_thread_num()), "parse", "file", (int)i);
+					mp.loadFile(modelFile.c_str(), true);
+				}
 				const vector<vec>& verts = mp.getVertices();
 				const vector<int3>& tris = mp.getTriangles();
 				const vector<vec>& norm = mp.getVertexNormals();
@@ -822,7 +1127,10 @@ void RayTracer::prepareRaytracing()
 			else if(modelFile.find(".off") != string::npos)
 			{
 				ModelParser mp;
-				mp.loadFile(modelFile.c_str(), true);
+				{
+					TraceScope parseScope(trace.getBuffer(omp_get_thread_num()), "parse", "file", (int)i);
+					mp.loadFile(modelFile.c_str(), true);
+				}
 				const vector<vec>& verts = mp.getVertices();
 				const vector<int3>& tris = mp.getTriangles();
 				const vector<vec>& norm = mp.getVertexNormals();
@@ -862,7 +1170,10 @@ void RayTracer::prepareRaytracing()
 				vector<vec> vertices;
 				vector<vec> normals;
 				vector<int3> tris;
-				loadPly(modelFile.c_str(), vertices, normals, tris);
+				{
+					TraceScope parseScope(trace.getBuffer(omp_get_thread_num()), "parse", "file", (int)i);
+					loadPly(modelFile.c_str(), vertices, normals, tris);
+				}
 
 				// create dummy material
 				if(ignoreMaterials)
@@ -933,8 +1244,8 @@ void RayTracer::prepareRaytracing()
 		testSetup.clear();
 	}
 
-	// create scene
-	SceneConstructionDetails details = createScene(methods[currentMethod]);
+	// create scene. the automatic selection probes the scenes with the camera, so it starts with SSH and decides after the camera is set.
+	SceneConstructionDetails details = createScene(methods[currentMethod] == AUTO ? SSH : methods[currentMethod]);
 
 	const AABBox& sceneAABB = scene->getBounds();
 	sceneSize = sceneAABB.max.x - sceneAABB.min.x;
@@ -989,7 +1300,7 @@ void RayTracer::prepareRaytracing()
 			else
 			{
 				// find optimum camera settings when not in video mode
-				if(mode == TEST)
+				if(mode == TEST || mode == BENCHMARK)
 				{
 					assert(camera);
 					camera->lookAt(scene->getBounds());
@@ -1021,8 +1332,19 @@ void RayTracer::prepareRaytracing()
 		}
 	}
 
+	if(methods[currentMethod] == AUTO) details = selectScene(details);
+	constructionDetails = details;
+
+	// separate pass after the construction. not part of the construction time.
+	if(makeStats)
+	{
+		TraceScope scope(trace.getBuffer(omp_get_thread_num()), "analysis");
+		testSetup.hierarchyAnalyzed = scene->analyze(testSetup.hierarchy);
+	}
+
 	// camera speed depends on scene size
 	const AABBox& aabb = scene->getBounds();
+	rayQueueSorter.setBounds(aabb);
 	float size = aabb.max.x - aabb.min.x;
 	size = MAX(size, aabb.max.y - aabb.min.y);
 	size = MAX(size, aabb.max.z - aabb.min.z);
@@ -1034,19 +1356,15 @@ void RayTracer::prepareRaytracing()
 	
 	if(makeStats)
 	{
-		testSetup.print(mode == TEST, details, scene->getComputedMemoryUsage(), modelFiles[currentModelFile], methods[currentMethod], getMethodStr(methods[currentMethod]), framesPerTest, scene, width, height);
+		testSetup.print(mode == TEST, details, scene->getComputedMemoryUsage(), modelFiles[currentModelFile], sceneType, getMethodStr(sceneType), framesPerTest, scene, width, height);
 	
 		#if 0
 			// print surface approximation to file
-			if(methods[currentMethod] == SSH)
+			if(sceneType == SSH)
 			{
 				ofstream fil("testresults/surface.txt", ios_base::app);
 				fil << modelFiles[currentModelFile] << " - average SSH node surface ratio approx/real: "
-				#ifdef BIGFLOAT_SURFACE_COMPUTATION		
-						<< details.bshSurfaceRatio.getdouble() << endl;
-				#else
-						<< details.bshSurfaceRatio << endl;
-				#endif
+						<< testSetup.hierarchy.meanSurfaceRatio << endl;
 				fil.close();
 			}
 		#endif
@@ -1063,6 +1381,7 @@ SceneConstructionDetails RayTracer::createScene(SCENE_TYPE type)
 {
 	// delete scene, construction strategy and geometry
 	if(scene) delete scene;
+	sceneType = type;
 
 	switch(type)
 	{
@@ -1070,10 +1389,21 @@ SceneConstructionDetails RayTracer::createScene(SCENE_TYPE type)
 		std::cout << "Creating BVH" << endl;
 		scene = new BoundingVolumeHierarchy(new BoundingVolumeHierarchySpatialMedianCut());
 	break;
+	case AUTO:
+		// the automatic selection builds its candidates with their own types (see selectScene). AUTO itself falls back to SSH
+		sceneType = SSH;
 	case SSH:
 		std::cout << "Creating SSH" << endl;
 		scene = new SingleSlabHierarchy(new SingleSlabHierarchySpatialMedianCut());
 	break;
+	case DSH:
+		std::cout << "Creating DSH" << endl;
+		scene = new DualSlabHierarchy(new DualSlabHierarchySpatialMedianCut());
+	break;
+	case HYBRID:
+		std::cout << "Creating hybrid hierarchy" << endl;
+		scene = new HybridHierarchy(new HybridHierarchySpatialMedianCut(memoryBudget));
+	break;
 	case KD:
 		std::cout << "kd-Trees are not supported yet" << endl; 
 		exit(0);
@@ -1086,77 +1416,204 @@ SceneConstructionDetails RayTracer::createScene(SCENE_TYPE type)
 	break;
 	}
 
+	// record the rays passed to the scene until the first frame has been recorded
+	rayRecorder = NULL;
+	if(!rayRecordFile.empty())
+	{
+		rayRecorder = new RecordingScene(scene);
+		scene = rayRecorder;
+	}
+
 	SceneConstructionDetails result;
+	TraceScope scope(trace.getBuffer(omp_get_thread_num()), "construction");
 
-	// construct
-	if(makeStats)
+	// construct. measured without measurements as well for the automatic method selection.
+	constructionTimeMeasurement.restart();
+	result = scene->construct(&triangles);
+	testSetup.constructionTime = constructionTimeMeasurement.getCurrentTime();
+
+	return result;
+}
+
+/// traversal time of the primary ray packets of a probe frame with the current camera
+double RayTracer::probeScene()
+{
+	// every step-th packet in both directions. a packet covers 2x2 pixels.
+	int packets = ((width+1)/2) * ((height+1)/2);
+	int step = 1;
+	while(packets / (step*step) > AUTO_PROBE_PACKETS) ++step;
+	int columns = ((width+1)/2 + step-1) / step;
+	int rows = ((height+1)/2 + step-1) / step;
+	int count = columns * rows;
+
+	std::vector<PackedRay*> rays(count);
+	for (int i = 0; i < count; ++i)
 	{
-		constructionTimeMeasurement.restart();
-		result = scene->construct(&triangles);
-		testSetup.constructionTime = constructionTimeMeasurement.getCurrentTime();
+		rays[i] = new PackedRay();
 	}
-	else
+
+	double best = -1.0;
+	for (int r = 0; r < AUTO_PROBE_REPEAT; ++r)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			camera->getRays(*rays[i], 2*step*(i % columns), 2*step*(i / columns));
+		}
+
+		TimeMeasurement time;
+		#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+		for (int i = 0; i < count; i += 16)
+		{
+			IntersectDetails details;
+			scene->intersectPackets(&rays[i], count - i < 16 ? count - i : 16, details);
+		}
+		double seconds = time.getCurrentTime();
+		if(best < 0.0 || seconds < best) best = seconds;
+	}
+
+	for (int i = 0; i < count; ++i)
 	{
-		result = scene->construct(&triangles);
+		delete rays[i];
 	}
 
-	return result;
+	// the probe has fewer packets than the frame
+	return best * double(packets) / count;
+}
+
+/*
+	automatic method selection. builds each candidate and estimates its cost for the frames of the mode as construction time
+	plus the primary ray traversal time of a probe frame. the cheapest candidate within the memory budget is kept.
+	if no candidate fits into the budget, the smallest one is kept. details are the ones of the current scene, which is an SSH.
+*/
+SceneConstructionDetails RayTracer::selectScene(const SceneConstructionDetails& details)
+{
+	std::vector<SCENE_TYPE> candidates;
+	candidates.push_back(SSH);
+	candidates.push_back(BVH);
+	candidates.push_back(DSH);
+	candidates.push_back(HYBRID);
+	if(triangles.size() <= AUTO_SIMPLE_MAX_TRIANGLES) candidates.push_back(SIMPLE);
+
+	double frames = mode == INTERACTIVE ? AUTO_INTERACTIVE_FRAMES : (mode == VIDEO ? 1 : framesPerTest);
+	std::cout << "automatic method selection for " << frames << " frames";
+	if(memoryBudget) std::cout << " and " << memoryBudget / 1024 << " KB";
+	std::cout << ":" << endl;
+
+	// the current scene is the best one so far. the others are built next to it.
+	Scene* bestScene = NULL;
+	SCENE_TYPE bestType = sceneType;
+	SceneConstructionDetails bestDetails = details;
+	double bestConstructionTime = testSetup.constructionTime;
+	double bestCost = 0.0;
+	unsigned long bestMemory = 0;
+
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		SceneConstructionDetails candidateDetails = details;
+		if(i != 0)
+		{
+			scene = NULL;	// createScene would delete the best scene
+			candidateDetails = createScene(candidates[i]);
+		}
+		double constructionTime = testSetup.constructionTime;
+
+		unsigned long memory = scene->getComputedMemoryUsage();
+		double frameTime = probeScene();
+		double cost = constructionTime + frames * frameTime;
+		bool fits = memoryBudget == 0 || memory <= memoryBudget;
+
+		std::cout << "  " << getMethodStr(candidates[i]) << ": construction " << constructionTime << " s, " << memory / 1024 << " KB, primary traversal "
+			<< frameTime << " s per frame, cost " << cost << " s" << (fits ? "" : ", over budget") << endl;
+
+		bool bestFits = memoryBudget == 0 || bestMemory <= memoryBudget;
+		bool better = i == 0 || (fits && !bestFits) || (fits && cost < bestCost) || (!fits && !bestFits && memory < bestMemory);
+		if(better)
+		{
+			delete bestScene;
+			bestScene = scene;
+			bestType = candidates[i];
+			bestDetails = candidateDetails;
+			bestConstructionTime = constructionTime;
+			bestCost = cost;
+			bestMemory = memory;
+		}
+		else
+		{
+			delete scene;
+		}
+	}
+
+	scene = bestScene;
+	sceneType = bestType;
+	testSetup.constructionTime = bestConstructionTime;
+	// each candidate has its own recorder
+	rayRecorder = rayRecordFile.empty() ? NULL : static_cast<RecordingScene*>(scene);
+
+	std::cout << "  selected " << getMethodStr(sceneType) << (memoryBudget && bestMemory > memoryBudget ? ". no method fits into the memory budget." : "") << endl;
+	return bestDetails;
 }
 
 void RayTracer::castShadowRay(ShadowRay& sray)
 {
 	if(shadows)
 	{
-		scene->intersect(*sray.ray);
+		{
+			StageScope scope(getStageTimer(omp_get_thread_num()), StageTimer::SHADOW_TRAVERSAL);
+			if(rayRecorder) rayRecorder->setKind(RecordingScene::SHADOW);
+			scene->intersect(sray.ray);
+		}
+		threadContexts[omp_get_thread_num()]->secondaryRays += (sray.destination[0] != 0) + (sray.destination[1] != 0) + (sray.destination[2] != 0) + (sray.destination[3] != 0);
 
-		if((*sray.destination)[0] && !sray.ray->hit[0]) *(*sray.destination)[0] += vec(sray.color->x[0], sray.color->y[0], sray.color->z[0]);
-		if((*sray.destination)[1] && !sray.ray->hit[1]) *(*sray.destination)[1] += vec(sray.color->x[1], sray.color->y[1], sray.color->z[1]);
-		if((*sray.destination)[2] && !sray.ray->hit[2]) *(*sray.destination)[2] += vec(sray.color->x[2], sray.color->y[2], sray.color->z[2]);
-		if((*sray.destination)[3] && !sray.ray->hit[3]) *(*sray.destination)[3] += vec(sray.color->x[3], sray.color->y[3], sray.color->z[3]);
+		if(sray.destination[0] && !sray.ray.hit[0]) *sray.destination[0] += vec(sray.color.x[0], sray.color.y[0], sray.color.z[0]);
+		if(sray.destination[1] && !sray.ray.hit[1]) *sray.destination[1] += vec(sray.color.x[1], sray.color.y[1], sray.color.z[1]);
+		if(sray.destination[2] && !sray.ray.hit[2]) *sray.destination[2] += vec(sray.color.x[2], sray.color.y[2], sray.color.z[2]);
+		if(sray.destination[3] && !sray.ray.hit[3]) *sray.destination[3] += vec(sray.color.x[3], sray.color.y[3], sray.color.z[3]);
 	}
 	else
 	{
-		if((*sray.destination)[0]) *(*sray.destination)[0] += vec(sray.color->x[0], sray.color->y[0], sray.color->z[0]);
-		if((*sray.destination)[1]) *(*sray.destination)[1] += vec(sray.color->x[1], sray.color->y[1], sray.color->z[1]);
-		if((*sray.destination)[2]) *(*sray.destination)[2] += vec(sray.color->x[2], sray.color->y[2], sray.color->z[2]);
-		if((*sray.destination)[3]) *(*sray.destination)[3] += vec(sray.color->x[3], sray.color->y[3], sray.color->z[3]);
+		if(sray.destination[0]) *sray.destination[0] += vec(sray.color.x[0], sray.color.y[0], sray.color.z[0]);
+		if(sray.destination[1]) *sray.destination[1] += vec(sray.color.x[1], sray.color.y[1], sray.color.z[1]);
+		if(sray.destination[2]) *sray.destination[2] += vec(sray.color.x[2], sray.color.y[2], sray.color.z[2]);
+		if(sray.destination[3]) *sray.destination[3] += vec(sray.color.x[3], sray.color.y[3], sray.color.z[3]);
 	}
-	
-	delete sray.color;
-	delete sray.destination;
-	delete sray.ray;
 }
 
 void RayTracer::castRefxxctionRay(RefxxctionRay& sray)
 {
-	scene->intersect(*sray.ray);
+	StageTimer* timer = getStageTimer(omp_get_thread_num());
+	int enclosing = timer ? timer->enter(StageTimer::refxxctionStage(LEVELS - sray.level)) : (int)StageTimer::OTHER;
+
+	if(rayRecorder) rayRecorder->setKind(RecordingScene::REFXXCTION);
+	scene->intersect(sray.ray);
+	threadContexts[omp_get_thread_num()]->secondaryRays += (sray.destination[0] != 0) + (sray.destination[1] != 0) + (sray.destination[2] != 0) + (sray.destination[3] != 0);
+
+	if(timer) timer->enter(StageTimer::SHADING);
 
-	quad<Triangle*> hit0(sray.ray->hit[0]);
-	if((*sray.destination)[1] && (sray.ray->hit == hit0).allTrue())
+	quad<Triangle*> hit0(sray.ray.hit[0]);
+	if(!sray.repacked && sray.destination[1] && (sray.ray.hit == hit0).allTrue())
 	{
 		// more than 1 destination -> packed ray
+		// && lanes come from one coherent packet
 		// && all 4 rays hit the same triangle
-		if((*sray.destination)[0] && sray.ray->hit[0]) sray.ray->hit[0]->material->shade(*sray.destination, *sray.contribution, sray.level, lights, *sray.ray);
+		if(sray.destination[0] && sray.ray.hit[0]) sray.ray.hit[0]->material->shade(sray.destination, sray.contribution, sray.level, lights, sray.ray);
 	}
 	else
 	{
 		// single rays or rays hit different triangles
-		vec contribution0 = vec(sray.contribution->x[0], sray.contribution->y[0], sray.contribution->z[0]);
-		vec contribution1 = vec(sray.contribution->x[1], sray.contribution->y[1], sray.contribution->z[1]);
-		vec contribution2 = vec(sray.contribution->x[2], sray.contribution->y[2], sray.contribution->z[2]);
-		vec contribution3 = vec(sray.contribution->x[3], sray.contribution->y[3], sray.contribution->z[3]);
-		if((*sray.destination)[0] && sray.ray->hit[0]) sray.ray->hit[0]->material->shade(*(*sray.destination)[0], contribution0, sray.level, lights, *sray.ray, 0);
-		if((*sray.destination)[1] && sray.ray->hit[1]) sray.ray->hit[1]->material->shade(*(*sray.destination)[1], contribution1, sray.level, lights, *sray.ray, 1);
-		if((*sray.destination)[2] && sray.ray->hit[2]) sray.ray->hit[2]->material->shade(*(*sray.destination)[2], contribution2, sray.level, lights, *sray.ray, 2);
-		if((*sray.destination)[3] && sray.ray->hit[3]) sray.ray->hit[3]->material->shade(*(*sray.destination)[3], contribution3, sray.level, lights, *sray.ray, 3);
+		vec contribution0 = vec(sray.contribution.x[0], sray.contribution.y[0], sray.contribution.z[0]);
+		vec contribution1 = vec(sray.contribution.x[1], sray.contribution.y[1], sray.contribution.z[1]);
+		vec contribution2 = vec(sray.contribution.x[2], sray.contribution.y[2], sray.contribution.z[2]);
+		vec contribution3 = vec(sray.contribution.x[3], sray.contribution.y[3], sray.contribution.z[3]);
+		if(sray.destination[0] && sray.ray.hit[0]) sray.ray.hit[0]->material->shade(*sray.destination[0], contribution0, sray.level, lights, sray.ray, 0);
+		if(sray.destination[1] && sray.ray.hit[1]) sray.ray.hit[1]->material->shade(*sray.destination[1], contribution1, sray.level, lights, sray.ray, 1);
+		if(sray.destination[2] && sray.ray.hit[2]) sray.ray.hit[2]->material->shade(*sray.destination[2], contribution2, sray.level, lights, sray.ray, 2);
+		if(sray.destination[3] && sray.ray.hit[3]) sray.ray.hit[3]->material->shade(*sray.destination[3], contribution3, sray.level, lights, sray.ray, 3);
 	}
-	
-	delete sray.destination;
-	delete sray.ray;
-	delete sray.contribution;
+
+	if(timer) timer->leave(enclosing);
 }
 
-void RayTracer::castRefxxctionRay(vector<RefxxctionRay>& refxxctionRays)
+void RayTracer::castRefxxctionRay(RayArena<RefxxctionRay>& refxxctionRays)
 {
 	for (int i = 0; i < (int)refxxctionRays.size(); ++i)
 	{
@@ -1165,191 +1622,571 @@ void RayTracer::castRefxxctionRay(vector<RefxxctionRay>& refxxctionRays)
 	refxxctionRays.clear();
 }
 
-/**
-* renders the scene
-*/
-void RayTracer::render()
+/// shades the 2x2 pixels at (x,y) hit by a primary ray packet
+void RayTracer::shadePrimaryRays(PackedRay& r, int x, int y)
 {
-	// clear screen
-	glClear ( GL_COLOR_BUFFER_BIT );
-
-	// initialize measurements
-	if(makeStats)
-	{
-		Triangle::intersectionTestsPerformed = 0;
-		testResult.rayNodeIntersections = 0;
-	}
-
-	PackedRay r;
-	
-	// prepare display method for color write
-	assert(openglImage);
-	if(makeStats)
+	quad<Triangle*> hit0(r.hit[0]);
+	if((r.hit == hit0).allTrue())
 	{
-		displayTimeMeasurement.restart();
-		openglImage->beginWrite();
-		displayTimeMeasurement.pause();
-
-		raytraceTimeMeasurement.restart();
-		traversalTimeMeasurement.restart();
+		// all 4 rays hit the same triangle
+		quad<vec*> destination(
+			&(*renderTarget)[y][x],
+			&(*renderTarget)[y][x+1],
+			&(*renderTarget)[y+1][x],
+			&(*renderTarget)[y+1][x+1]);
+
+		if(r.hit[0]) r.hit[0]->material->shade(destination, qfloat(1.f), LEVELS, lights, r);
+		else if(background)
+		{
+			// show ray direction in the background for debugging
+			renderTarget->setPixel(x,   y,   vec(r.dir.x[0], r.dir.y[0], r.dir.z[0]));
+			renderTarget->setPixel(x+1, y,   vec(r.dir.x[1], r.dir.y[1], r.dir.z[1]));
+			renderTarget->setPixel(x,   y+1, vec(r.dir.x[2], r.dir.y[2], r.dir.z[2]));
+			renderTarget->setPixel(x+1, y+1, vec(r.dir.x[3], r.dir.y[3], r.dir.z[3]));
+		}
 	}
 	else
 	{
-		openglImage->beginWrite();
+		if(r.hit[0]) r.hit[0]->material->shade((*renderTarget)[y][x], 1, LEVELS, lights, r, 0);
+		if(r.hit[1]) r.hit[1]->material->shade((*renderTarget)[y][x+1], 1, LEVELS, lights, r, 1);
+		if(r.hit[2]) r.hit[2]->material->shade((*renderTarget)[y+1][x], 1, LEVELS, lights, r, 2);
+		if(r.hit[3]) r.hit[3]->material->shade((*renderTarget)[y+1][x+1], 1, LEVELS, lights, r, 3);
 	}
-	
-	// clear image. secondary rays need to add their shading results to the image instead of just setting it. 
+}
+
+/// traces the primary rays of a tile and queues the secondary rays
+void RayTracer::renderTile(const TileScheduler::Tile& tile)
+{
+	// clear tile. secondary rays need to add their shading results to the image instead of just setting it. 
 	// we could use the same algorithm for primary and secondary rays if the primary rays also added their result
 	// instead of setting it. therefore we clean the image so that the primary rays can add their shading result to the
 	// existing zeros.
-#ifdef MULTITHREADING
-	#pragma omp parallel for private(r) num_threads(THREAD_COUNT)
-#endif
-	for (int x = 0; x < width; x += 2)
+	StageTimer* timer = getStageTimer(omp_get_thread_num());
+	int enclosing = timer ? timer->enter(StageTimer::CLEAR) : (int)StageTimer::OTHER;
+
+	static vec black(0,0,0);
+	for (int y = tile.y0; y < tile.y1; ++y)
 	{
-		for (int y = 0; y < height; y += 2)
+		for (int x = tile.x0; x < tile.x1; ++x)
 		{
-			static vec black(0,0,0);
-			openglImage->setPixel(x,   y,   black);
-			openglImage->setPixel(x+1, y,   black);
-			openglImage->setPixel(x,   y+1, black);
-			openglImage->setPixel(x+1, y+1, black);
+			renderTarget->setPixel(x, y, black);
 		}
 	}
 
-	// private(r): do not share r between threads
-#ifdef MULTITHREADING
-	#pragma omp parallel for private(r) num_threads(THREAD_COUNT)
-#endif
-	for (int x = 0; x < width; x += 2)
+	for (int x = tile.x0; x < tile.x1; x += 2)
 	{
-		for (int y = 0; y < height; y += 2)
-		{
-			assert(camera);
-			camera->getRays(r, x, y);
+		#if INTERLEAVED_PACKETS > 1
+			// packets of one column are traversed interleaved
+			PackedRay packets[INTERLEAVED_PACKETS];
+			PackedRay* packetPointers[INTERLEAVED_PACKETS];
+			for (int i = 0; i < INTERLEAVED_PACKETS; ++i)
+			{
+				packetPointers[i] = &packets[i];
+			}
 
-			#ifndef MULTITHREADING
-				if(makeStats)
+			for (int y = tile.y0; y < tile.y1; y += 2*INTERLEAVED_PACKETS)
+			{
+				if(timer) timer->enter(StageTimer::CAMERA_RAYS);
+				int count = 0;
+				for (int py = y; py < tile.y1 && count < INTERLEAVED_PACKETS; py += 2, ++count)
+				{
+					assert(frameCamera);
+					frameCamera->getRays(packets[count], x, py);
+				}
+
+				// measurement is possible in single-thread mode only due to missing thread synchronization
+				if(makeStats && threads == 1)
 				{
 					// measurement is paused while shading. resume the measurement for upcoming traversal.
 					traversalTimeMeasurement.resume();
 				}
-			#endif
 
-			IntersectDetails details = scene->intersect(r);
+				if(timer) timer->enter(StageTimer::PRIMARY_TRAVERSAL);
+				IntersectDetails details;
+				details.rayNodeIntersections = 0;
 
-			#ifndef MULTITHREADING
-				if(makeStats)
+				LaneCounters lanes[INTERLEAVED_PACKETS];
+				if(heatmap != NO_HEATMAP)
+				{
+					for (int i = 0; i < count; ++i) lanes[i].clear();
+					details.lanes = lanes;
+				}
+
+				if(rayRecorder) rayRecorder->setKind(RecordingScene::PRIMARY);
+				scene->intersectPackets(packetPointers, count, details);
+
+				if(heatmap != NO_HEATMAP)
+				{
+					for (int i = 0; i < count; ++i) storeHeatmapCounts(lanes[i], x, y + 2*i);
+				}
+
+				if(makeStats && threads == 1)
 				{
 					// we do not want to measure the shading. pause until next traversal.
 					traversalTimeMeasurement.pause();
 
-					// TODO use atomic add operation to enable this measurement in multithreading mode without synchronization
 					testResult.rayNodeIntersections += details.rayNodeIntersections;
 				}
-			#endif
 
-			quad<Triangle*> hit0(r.hit[0]);
-			if((r.hit == hit0).allTrue())
-			{
-				// all 4 rays hit the same triangle
-				quad<vec*> destination(
-					&(*openglImage)[y][x],
-					&(*openglImage)[y][x+1],
-					&(*openglImage)[y+1][x],
-					&(*openglImage)[y+1][x+1]);
-
-				if(r.hit[0]) r.hit[0]->material->shade(destination, qfloat(1.f), LEVELS, lights, r);
-				else if(background)
+				if(timer) timer->enter(StageTimer::SHADING);
+				for (int i = 0; i < count; ++i)
 				{
-					// show ray direction in the background for debugging
-					openglImage->setPixel(x,   y,   vec(r.dir.x[0], r.dir.y[0], r.dir.z[0]));
-					openglImage->setPixel(x+1, y,   vec(r.dir.x[1], r.dir.y[1], r.dir.z[1]));
-					openglImage->setPixel(x,   y+1, vec(r.dir.x[2], r.dir.y[2], r.dir.z[2]));
-					openglImage->setPixel(x+1, y+1, vec(r.dir.x[3], r.dir.y[3], r.dir.z[3]));
+					shadePrimaryRays(packets[i], x, y + 2*i);
 				}
 			}
-			else
+		#else
+			PackedRay r;
+			for (int y = tile.y0; y < tile.y1; y += 2)
 			{
-				if(r.hit[0]) r.hit[0]->material->shade((*openglImage)[y][x], 1, LEVELS, lights, r, 0);
-				if(r.hit[1]) r.hit[1]->material->shade((*openglImage)[y][x+1], 1, LEVELS, lights, r, 1);
-				if(r.hit[2]) r.hit[2]->material->shade((*openglImage)[y+1][x], 1, LEVELS, lights, r, 2);
-				if(r.hit[3]) r.hit[3]->material->shade((*openglImage)[y+1][x+1], 1, LEVELS, lights, r, 3);
-			}
-		}
-	}
+				if(timer) timer->enter(StageTimer::CAMERA_RAYS);
+				assert(frameCamera);
+				frameCamera->getRays(r, x, y);
 
-	// trace secondary rays
-		
-	for (int level = 0; level < LEVELS; ++level)
-	{
-		// shadow rays can be traversed recursively (instantly) or iteratively (after the primary rays).
-		// the iterative version allows for further optimizations i.e. tracing ray bundles.
-		// the recursive version uses less memory than the iterative version since there is no queue.
-		#ifdef ITERATIVE_SHADOWS
-			// trace shadow rays
-			#ifdef MULTITHREADING
-				// with multithreading each thread has its own queue to minimize synchronization
-				for (int thread = 0; thread < THREAD_COUNT; ++thread)
+				// measurement is possible in single-thread mode only due to missing thread synchronization
+				if(makeStats && threads == 1)
 				{
-					#pragma omp parallel for private(r) num_threads(THREAD_COUNT)
-					for (int i = 0; i < (int)shadowRays[thread].size(); ++i)
-					{
-						castShadowRay(shadowRays[thread][i]);
-					}
-					shadowRays[thread].clear();
+					// measurement is paused while shading. resume the measurement for upcoming traversal.
+					traversalTimeMeasurement.resume();
+				}
+
+				if(timer) timer->enter(StageTimer::PRIMARY_TRAVERSAL);
+				IntersectDetails details;
+				if(heatmap != NO_HEATMAP)
+				{
+					// the cost per lane is counted by intersectPackets only
+					LaneCounters lanes;
+					lanes.clear();
+					details.lanes = &lanes;
+					PackedRay* packet = &r;
+					if(rayRecorder) rayRecorder->setKind(RecordingScene::PRIMARY);
+					scene->intersectPackets(&packet, 1, details);
+					storeHeatmapCounts(lanes, x, y);
 				}
-			#else
-				for (int i = 0; i < (int)shadowRays.size(); ++i)
+				else
 				{
-					castShadowRay(shadowRays[i]);
+					if(rayRecorder) rayRecorder->setKind(RecordingScene::PRIMARY);
+					details = scene->intersect(r);
 				}
-				shadowRays.clear();
-			#endif
-		#endif
-		
-		// trace reflection/refraction rays
-		#ifdef MULTITHREADING
-			// with multithreading each thread has its own queue to avoid synchronization
-			#pragma omp parallel for private(r) num_threads(THREAD_COUNT)
-			for (int thread = 0; thread < THREAD_COUNT; ++thread)
-			{
-				castRefxxctionRay(*refxxctionRays[thread]);
-			}
-		#else
-			castRefxxctionRay(*refxxctionRays);
-		#endif
 
-		// swap refxxtionRays vectors. tracing reflection/refraction rays can produce more reflection/refraction rays which 
-		// need to be stored in another queue, so there are two queues which are swapped when one queue is empty.
-		// this wouldn't be neccessary if the queues were real queues (linked lists), but here we use vectors to reduce memory usage and increase cache coherency.
-		#ifdef MULTITHREADING
-			vector<RefxxctionRay>* readingRefxxctionRays[THREAD_COUNT];
-			for (int thread = 0; thread < THREAD_COUNT; ++thread)
-			{
-				readingRefxxctionRays[thread] = refxxctionRays[thread];
-				refxxctionRays[thread] = refxxctionRays[thread] == &refxxctionRaysA[thread] ? &refxxctionRaysB[thread] : &refxxctionRaysA[thread];
+				if(makeStats && threads == 1)
+				{
+					// we do not want to measure the shading. pause until next traversal.
+					traversalTimeMeasurement.pause();
+
+					// TODO use atomic add operation to enable this measurement in multithreading mode without synchronization
+					testResult.rayNodeIntersections += details.rayNodeIntersections;
+				}
+
+				if(timer) timer->enter(StageTimer::SHADING);
+				shadePrimaryRays(r, x, y);
 			}
-		#else
-			vector<RefxxctionRay>* readingRefxxctionRays = refxxctionRays;
-			refxxctionRays = refxxctionRays == &refxxctionRaysA ? &refxxctionRaysB : &refxxctionRaysA;
 		#endif
 	}
 
-	if(makeStats)
+	if(timer) timer->leave(enclosing);
+}
+
+/// allocates the state of each render thread. each thread allocates its own context, so the memory is local to the thread.
+void RayTracer::createThreadContexts()
+{
+	trace.reserveThreads(threads);
+
+	for (size_t i = 0; i < threadContexts.size(); ++i)
 	{
-		#ifndef MULTITHREADING
-			// pure traversal time is measureable in single-thread mode only due to missing thread synchronization
-			testResult.lastTraversalTime = traversalTimeMeasurement.getCurrentTime();
-			testResult.avgTraversalTime = traversalTimeMeasurement.getAverageTime();
-			if(testResult.minTraversalTime > testResult.lastTraversalTime) testResult.minTraversalTime = testResult.lastTraversalTime;
-			if(testResult.maxTraversalTime < testResult.lastTraversalTime) testResult.maxTraversalTime = testResult.lastTraversalTime;
-			if(testResult.firstTraversalTime < 0.0)
-			{
-				testResult.firstTraversalTime = testResult.lastTraversalTime;
+		delete threadContexts[i];
+	}
+	threadContexts.assign(threads, (ThreadContext*)0);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		ThreadContext* context = new ThreadContext();
+
+		// the counters count the thread which opens them. the runtime keeps its threads for the following parallel regions.
+		if(countEvents && context->perfCounters.open()) context->stageTimer.attach(&context->perfCounters);
+
+		threadContexts[omp_get_thread_num()] = context;
+	}
+
+	// the runtime might have started less threads. their counters stay closed.
+	for (int i = 0; i < threads; ++i)
+	{
+		if(!threadContexts[i]) threadContexts[i] = new ThreadContext();
+	}
+
+	if(countEvents)
+	{
+		const PerfCounters& counters = threadContexts[0]->perfCounters;
+		for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+		{
+			if(!counters.isAvailable(e)) std::cout << "hardware event not available: " << PerfCounters::getEventName(e) << endl;
+		}
+	}
+}
+
+/// shadow ray queue of a thread
+RayArena<ShadowRay>& RayTracer::getShadowRays(int thread)
+{
+	assert(thread < (int)threadContexts.size());
+	return threadContexts[thread]->shadowRays;
+}
+
+/// reflection/refraction ray queue of a thread which new rays are added to
+RayArena<RefxxctionRay>*& RayTracer::getRefxxctionRays(int thread)
+{
+	assert(thread < (int)threadContexts.size());
+	return threadContexts[thread]->refxxctionRays;
+}
+
+/// swaps the reflection/refraction ray queues of a thread and returns the queue which has to be traced.
+/// tracing reflection/refraction rays can produce more reflection/refraction rays which need to be stored in another queue.
+/// this wouldn't be neccessary if the queues were real queues (linked lists), but here we use vectors to reduce memory usage and increase cache coherency.
+RayArena<RefxxctionRay>* RayTracer::swapRefxxctionRays(int thread)
+{
+	ThreadContext& context = *threadContexts[thread];
+	RayArena<RefxxctionRay>* reading = context.refxxctionRays;
+	context.refxxctionRays = reading == &context.refxxctionRaysA ? &context.refxxctionRaysB : &context.refxxctionRaysA;
+	return reading;
+}
+
+/// number of threads that own ray queues
+int RayTracer::getQueueCount() const
+{
+	return (int)threadContexts.size();
+}
+
+/// stage timer of a thread. NULL if measurements are disabled.
+StageTimer* RayTracer::getStageTimer(int thread)
+{
+	if(!makeStats) return NULL;
+	assert(thread < (int)threadContexts.size());
+	return &threadContexts[thread]->stageTimer;
+}
+
+/// traces the secondary rays in the queues of a thread level by level until no rays are left
+void RayTracer::traceSecondaryRays(int thread)
+{
+	#ifdef ITERATIVE_SHADOWS
+		RayArena<ShadowRay>& shadowQueue = getShadowRays(thread);
+	#endif
+
+	// one iteration more than levels: the shadow rays of the last reflection/refraction level are traced in the last iteration
+	for (int level = 0; level <= LEVELS; ++level)
+	{
+		TraceScope scope(trace.getBuffer(thread), "secondary rays", "level", level);
+
+		// shadow rays can be traversed recursively (instantly) or iteratively (after the primary rays).
+		// the iterative version allows for further optimizations i.e. tracing ray bundles.
+		// the recursive version uses less memory than the iterative version since there is no queue.
+		#ifdef ITERATIVE_SHADOWS
+			if(sortSecondaryRays)
+			{
+				StageScope scope(getStageTimer(thread), StageTimer::SORTING);
+				rayQueueSorter.sortAndRepack(shadowQueue);
+			}
+			for (size_t i = 0; i < shadowQueue.size(); ++i)
+			{
+				castShadowRay(shadowQueue[i]);
+			}
+			shadowQueue.clear();
+		#endif
+
+		// tiles without reflection/refraction are done after the first level
+		if(getRefxxctionRays(thread)->empty()) break;
+
+		// trace reflection/refraction rays
+		RayArena<RefxxctionRay>* readingRefxxctionRays = swapRefxxctionRays(thread);
+		if(sortSecondaryRays)
+		{
+			StageScope scope(getStageTimer(thread), StageTimer::SORTING);
+			rayQueueSorter.sortAndRepack(*readingRefxxctionRays);
+		}
+		castRefxxctionRay(*readingRefxxctionRays);
+	}
+}
+
+/// returns the number of rays in the queues
+template <class T>
+static int countQueuedRays(const std::vector<RayArena<T>*>& queues)
+{
+	int count = 0;
+	for (size_t i = 0; i < queues.size(); ++i)
+	{
+		count += (int)queues[i]->size();
+	}
+	return count;
+}
+
+/// traces the secondary rays of all threads level by level. all threads of the enclosing parallel region have to call this method.
+/// the queues of all threads are dealt to the threads per level, so a thread which runs out of rays takes over the queues of others.
+/// a queue is traced by one thread only: all rays of a pixel are in the same queue and add to the pixel without synchronization.
+void RayTracer::traceSecondaryRaysGlobal()
+{
+	const int queueCount = getQueueCount();
+
+	// one iteration more than levels: the shadow rays of the last reflection/refraction level are traced in the last iteration
+	for (int level = 0; level <= LEVELS; ++level)
+	{
+		TraceScope scope(trace.getBuffer(omp_get_thread_num()), "secondary pass", "level", level);
+
+		#ifdef ITERATIVE_SHADOWS
+			#pragma omp single
+			{
+				secondaryShadowQueues.resize(queueCount);
+				for (int i = 0; i < queueCount; ++i)
+				{
+					secondaryShadowQueues[i] = &getShadowRays(i);
+				}
+			}
+
+			#pragma omp for schedule(dynamic, 1)
+			for (int i = 0; i < queueCount; ++i)
+			{
+				RayArena<ShadowRay>& queue = *secondaryShadowQueues[i];
+				if(sortSecondaryRays)
+				{
+					StageScope scope(getStageTimer(omp_get_thread_num()), StageTimer::SORTING);
+					rayQueueSorter.sortAndRepack(queue);
+				}
+				for (size_t r = 0; r < queue.size(); ++r)
+				{
+					castShadowRay(queue[r]);
+				}
+				queue.clear();
 			}
 		#endif
 
+		// swap the queues of all threads. rays spawned in this pass go to the queue of the thread which traces the parent ray.
+		#pragma omp single
+		{
+			secondaryRefxxctionQueues.resize(queueCount);
+			for (int i = 0; i < queueCount; ++i)
+			{
+				secondaryRefxxctionQueues[i] = swapRefxxctionRays(i);
+			}
+			secondaryRayCount = countQueuedRays(secondaryRefxxctionQueues);
+		}
+
+		// the frame is done if there are no reflection/refraction rays left. all threads see the same count after the barrier of single.
+		if(secondaryRayCount == 0) break;
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int i = 0; i < queueCount; ++i)
+		{
+			RayArena<RefxxctionRay>& queue = *secondaryRefxxctionQueues[i];
+			if(sortSecondaryRays)
+			{
+				StageScope scope(getStageTimer(omp_get_thread_num()), StageTimer::SORTING);
+				rayQueueSorter.sortAndRepack(queue);
+			}
+			castRefxxctionRay(queue);
+			queue.clear();
+		}
+	}
+}
+
+/// stores the traversal cost of a primary ray packet for the heatmap. lanes are ordered like the pixels in shadePrimaryRays.
+void RayTracer::storeHeatmapCounts(const LaneCounters& lanes, int x, int y)
+{
+	const unsigned int* counts = heatmap == NODE_HEATMAP ? lanes.nodeVisits : lanes.triangleTests;
+	heatmapCounts[y*width + x] = counts[0];
+	heatmapCounts[y*width + x+1] = counts[1];
+	heatmapCounts[(y+1)*width + x] = counts[2];
+	heatmapCounts[(y+1)*width + x+1] = counts[3];
+}
+
+/// replaces the shaded image by the heatmap. the colors go from blue over cyan, green and yellow to red at the maximum count of the frame.
+void RayTracer::drawHeatmap()
+{
+	unsigned int maximum = 1;
+	for (size_t i = 0; i < heatmapCounts.size(); ++i)
+	{
+		if(heatmapCounts[i] > maximum) maximum = heatmapCounts[i];
+	}
+	heatmapMaximum = maximum;
+
+	static const vec colors[5] = { vec(0,0,1), vec(0,1,1), vec(0,1,0), vec(1,1,0), vec(1,0,0) };
+	static vec black(0,0,0);
+
+	#pragma omp parallel for num_threads(threads)
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			unsigned int count = heatmapCounts[y*width + x];
+			if(count == 0)
+			{
+				renderTarget->setPixel(x, y, black);
+				continue;
+			}
+
+			float position = 4.0f * float(count) / float(maximum);
+			int segment = (int)position;
+			if(segment > 3) segment = 3;
+			float weight = position - segment;
+			renderTarget->setPixel(x, y, colors[segment] * (1.0f - weight) + colors[segment+1] * weight);
+		}
+	}
+}
+
+/// copies a traced frame to the display image and draws it. needs the OpenGL context, so only the master thread may call it.
+void RayTracer::presentFrame(IOpenGLImage* frame)
+{
+	if(makeStats) displayTimeMeasurement.restart();
+	TraceScope scope(trace.getBuffer(0), "display");
+
+	StageTimer* timer = getStageTimer(0);
+	int enclosing = timer ? timer->enter(StageTimer::CONVERT) : (int)StageTimer::OTHER;
+
+	openglImage->beginWrite();
+	for (int y = 0; y < height; ++y)
+	{
+		vec* row = (*frame)[y];
+		for (int x = 0; x < width; ++x)
+		{
+			openglImage->setPixel(x, y, row[x]);
+		}
+	}
+	openglImage->endWrite();
+
+	if(timer) timer->enter(StageTimer::DISPLAY);
+	openglImage->drawFullscreen();
+
+	if(timer) timer->leave(enclosing);
+	if(makeStats) displayTimeMeasurement.pause();
+}
+
+/**
+* renders the scene
+*/
+void RayTracer::render()
+{
+	TraceBuffer* masterTrace = trace.getBuffer(0);
+	double frameBegin = masterTrace || liveMetrics.isOpen() ? TimeMeasurement::now() : 0.0;
+
+	// clear screen
+#ifndef HEADLESS
+	if(!headless) glClear ( GL_COLOR_BUFFER_BIT );
+#endif
+
+	// initialize measurements
+	Triangle::countIntersectionTests = makeStats && threads == 1;
+	if(makeStats)
+	{
+		Triangle::intersectionTestsPerformed = 0;
+		testResult.rayNodeIntersections = 0;
+	}
+
+	// the frame is traced with the camera as it is now. input during the frame is applied to the next frame.
+	*frameCamera = *camera;
+
+	if(heatmap != NO_HEATMAP) heatmapCounts.resize(width * height);
+
+	if(rayRecorder) rayRecorder->start();
+
+	// prepare display method for color write
+	assert(openglImage);
+	if(pipeline)
+	{
+		// trace into the back buffer. the front buffer is displayed while the threads trace.
+		renderTarget = frameBuffers[backBuffer];
+	}
+	else
+	{
+		renderTarget = openglImage;
+	}
+
+	if(makeStats)
+	{
+		// the stages of all threads are measured from here until the frame is displayed
+		for (int i = 0; i < threads; ++i)
+		{
+			threadContexts[i]->stageTimer.beginFrame();
+			threadContexts[i]->secondaryRays = 0;
+		}
+
+		if(!pipeline)
+		{
+			displayTimeMeasurement.restart();
+			StageScope scope(getStageTimer(0), StageTimer::CONVERT);
+			openglImage->beginWrite();
+			displayTimeMeasurement.pause();
+		}
+
+		raytraceTimeMeasurement.restart();
+		traversalTimeMeasurement.restart();
+	}
+	else if(!pipeline)
+	{
+		openglImage->beginWrite();
+	}
+	
+	// the image is rendered in tiles. each thread traces the primary rays of a tile and then the secondary rays which were
+	// spawned by the tile, so all work of a tile stays in the cache of one core.
+	// alternatively the secondary rays of all tiles are traced together after the primary rays for better load balancing.
+	tileScheduler.setup(width, height, tileSize, threads);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		tileScheduler.setThreadNode(thread, NumaPlacement::getCurrentNode());
+
+		if(pipeline && thread == 0 && frontBufferValid)
+		{
+			// the master thread owns the OpenGL context. it displays the previous frame while the other threads
+			// start with the tiles of this frame and steals the tiles of its own range afterwards.
+			presentFrame(frameBuffers[1 - backBuffer]);
+		}
+
+		TileScheduler::Tile tile;
+		while(tileScheduler.nextTile(thread, tile))
+		{
+			TraceScope scope(trace.getBuffer(thread), "tile", "firstPixel", tile.y0*width + tile.x0);
+			renderTile(tile);
+			if(!globalSecondaryPasses) traceSecondaryRays(thread);
+		}
+
+		if(globalSecondaryPasses)
+		{
+			// wait for the primary rays of all tiles and trace the secondary rays of the frame together
+			#pragma omp barrier
+			traceSecondaryRaysGlobal();
+		}
+	}
+
+	if(heatmap != NO_HEATMAP) drawHeatmap();
+
+	if(rayRecorder)
+	{
+		rayRecorder->stop();
+		if(rayRecorder->save(rayRecordFile.c_str()))
+		{
+			std::cout << "recorded " << rayRecorder->getRecordCount() << " ray packets to " << rayRecordFile << endl;
+		}
+		else
+		{
+			std::cout << "could not write ray dump " << rayRecordFile << endl;
+		}
+
+		// one frame only. the recorder stays in front of the scene until the scene is replaced.
+		rayRecordFile.clear();
+		rayRecorder = NULL;
+	}
+
+	if(makeStats)
+	{
+		if(threads == 1)
+		{
+			// pure traversal time is measureable in single-thread mode only due to missing thread synchronization
+			testResult.lastTraversalTime = traversalTimeMeasurement.getCurrentTime();
+			testResult.avgTraversalTime = traversalTimeMeasurement.getAverageTime();
+			if(testResult.minTraversalTime > testResult.lastTraversalTime) testResult.minTraversalTime = testResult.lastTraversalTime;
+			if(testResult.maxTraversalTime < testResult.lastTraversalTime) testResult.maxTraversalTime = testResult.lastTraversalTime;
+			if(testResult.firstTraversalTime < 0.0)
+			{
+				testResult.firstTraversalTime = testResult.lastTraversalTime;
+			}
+		}
+
 		testResult.lastRayTraceTime = raytraceTimeMeasurement.getCurrentTime();
 		testResult.avgRayTraceTime = raytraceTimeMeasurement.getAverageTime();
 		if(testResult.minRayTraceTime > testResult.lastRayTraceTime) testResult.minRayTraceTime = testResult.lastRayTraceTime;
@@ -1357,35 +2194,83 @@ void RayTracer::render()
 		if(testResult.firstRayTraceTime < 0.0)
 		{
 			testResult.firstRayTraceTime = testResult.lastRayTraceTime;
-			if(mode != TEST) testResult.printFirstFrame();
+			if(mode != TEST && mode != BENCHMARK) testResult.printFirstFrame();
 		}
 
-		#ifndef MULTITHREADING
+		if(threads == 1)
+		{
 			// ray/triangle intersections is measureable in single-thread mode only due to missing thread synchronization
 			testResult.rayTriangleIntersections = Triangle::intersectionTestsPerformed;
-		#endif
+		}
 	}
 	
 	// download image to graphics card
 	
-	if(makeStats)
+	if(pipeline)
 	{
+		// the traced frame is displayed during the next frame
+		backBuffer = 1 - backBuffer;
+		frontBufferValid = true;
+	}
+	else if(makeStats)
+	{
+		TraceScope scope(masterTrace, "display");
 		displayTimeMeasurement.resume();
+		StageTimer* timer = getStageTimer(0);
+		int enclosing = timer->enter(StageTimer::CONVERT);
 		openglImage->endWrite();
+		timer->enter(StageTimer::DISPLAY);
 		openglImage->drawFullscreen();
+		timer->leave(enclosing);
 		displayTimeMeasurement.pause();
 		//cout << "Display time: " << displayTimeMeasurement.getCurrentTime() << " ; avg: " << displayTimeMeasurement.getAverageTime() << endl;
 	}
 	else
 	{
+		TraceScope scope(masterTrace, "display");
 		openglImage->endWrite();
 		openglImage->drawFullscreen();
 	}
 
+	if(makeStats)
+	{
+		// sum the stages of all threads. threads which finished early have waited in OTHER.
+		double stageTimes[StageTimer::STAGE_COUNT];
+		double stageEvents[StageTimer::STAGE_COUNT][PerfCounters::EVENT_COUNT];
+		for (int s = 0; s < StageTimer::STAGE_COUNT; ++s)
+		{
+			stageTimes[s] = 0.0;
+			for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) stageEvents[s][e] = 0.0;
+		}
+		for (int i = 0; i < threads; ++i)
+		{
+			StageTimer& timer = threadContexts[i]->stageTimer;
+			timer.endFrame();
+			for (int s = 0; s < StageTimer::STAGE_COUNT; ++s)
+			{
+				stageTimes[s] += timer.seconds[s];
+				for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) stageEvents[s][e] += timer.events[s][e];
+			}
+		}
+		testResult.addStageTimes(stageTimes);
+		if(threadContexts[0]->perfCounters.isOpen()) testResult.addStageEvents(stageEvents, threadContexts[0]->perfCounters);
+
+		if(liveMetrics.isOpen()) publishMetrics(TimeMeasurement::now() - frameBegin, stageTimes);
+	}
+	else if(liveMetrics.isOpen())
+	{
+		publishMetrics(TimeMeasurement::now() - frameBegin, NULL);
+	}
+
 	// switch back and front buffer
-	glutSwapBuffers();
+#ifndef HEADLESS
+	if(!headless) glutSwapBuffers();
+#endif
+
+	// the next test is prepared outside of the frame
+	if(masterTrace) masterTrace->add("frame", frameBegin, TimeMeasurement::now());
 
-	if(mode == TEST)
+	if(mode == TEST && !threadSweep)
 	{
 		++frameCounter;
 		if(frameCounter >= framesPerTest)
@@ -1395,10 +2280,10 @@ void RayTracer::render()
 				testResult.print(width, height);
 
 				// to find out if ssh was faster than bvh
-				if(methods[currentMethod] == SSH) sshMinTraversalTime = testResult.minTraversalTime < sshMinTraversalTime ? testResult.minTraversalTime : sshMinTraversalTime;
-				if(methods[currentMethod] == BVH) bvhMinTraversalTime = testResult.minTraversalTime < bvhMinTraversalTime ? testResult.minTraversalTime : bvhMinTraversalTime;
-				if(methods[currentMethod] == SSH) sshMinConstructionTime = testSetup.constructionTime < sshMinConstructionTime ? testSetup.constructionTime : sshMinConstructionTime;
-				if(methods[currentMethod] == BVH) bvhMinConstructionTime = testSetup.constructionTime < bvhMinConstructionTime ? testSetup.constructionTime : bvhMinConstructionTime;
+				if(sceneType == SSH) sshMinTraversalTime = testResult.minTraversalTime < sshMinTraversalTime ? testResult.minTraversalTime : sshMinTraversalTime;
+				if(sceneType == BVH) bvhMinTraversalTime = testResult.minTraversalTime < bvhMinTraversalTime ? testResult.minTraversalTime : bvhMinTraversalTime;
+				if(sceneType == SSH) sshMinConstructionTime = testSetup.constructionTime < sshMinConstructionTime ? testSetup.constructionTime : sshMinConstructionTime;
+				if(sceneType == BVH) bvhMinConstructionTime = testSetup.constructionTime < bvhMinConstructionTime ? testSetup.constructionTime : bvhMinConstructionTime;
 			}
 			
 			++currentMethod;
@@ -1439,6 +2324,10 @@ void RayTracer::render()
 			prepareRaytracing();
 		}
 	}
+	else if(mode == BENCHMARK || threadSweep)
+	{
+		// the configurations are switched by runBenchmark and runThreadSweep
+	}
 	else if(mode == INTERACTIVE)
 	{
 		if(makeStats)
@@ -1453,8 +2342,16 @@ void RayTracer::render()
 		char filename[260];
 		const char* modelFileName = modelFiles[currentModelFile];
 		while(strstr(modelFileName, "/")) modelFileName = strstr(modelFileName, "/")+1;	// extract file name
-		sprintf(filename, "images/%s.ppm", modelFileName);
-		openglImage->saveToFile(filename);
+		if(heatmap == NO_HEATMAP)
+		{
+			sprintf(filename, "images/%s.ppm", modelFileName);
+		}
+		else
+		{
+			sprintf(filename, "images/%s.%s.ppm", modelFileName, heatmap == NODE_HEATMAP ? "nodes" : "triangles");
+			std::cout << filename << ": red is " << heatmapMaximum << (heatmap == NODE_HEATMAP ? " node visits" : " triangle tests") << " per ray" << endl;
+		}
+		renderTarget->saveToFile(filename);
 
 		// load next model file
 		++currentModelFile;
@@ -1463,13 +2360,380 @@ void RayTracer::render()
 	}
 }
 
+/// reads the configurations of the benchmark mode. -resolution and -threads take comma separated lists in benchmark mode.
+void RayTracer::parseBenchmarkArguments(int argc, char** argv)
+{
+	std::vector<std::string> items;
+
+	const char* resarg = getArgument(argc, argv, "-resolution");
+	if(resarg) splitList(resarg, items);
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		int w, h;
+		if(2 != sscanf(items[i].c_str(), "%dx%d", &w, &h) || w < 1 || h < 1)
+		{
+			std::cout << "invalid resolution: " << items[i] << endl;
+			exit(-1);
+		}
+		benchmarkResolutions.push_back(std::pair<int,int>(w, h));
+	}
+	if(benchmarkResolutions.empty()) benchmarkResolutions.push_back(std::pair<int,int>(width, height));
+
+	items.clear();
+	const char* threadarg = getArgument(argc, argv, "-threads");
+	if(threadarg) splitList(threadarg, items);
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		int count = atoi(items[i].c_str());
+		if(count < 1)
+		{
+			std::cout << "thread count must be at least 1" << endl;
+			exit(-1);
+		}
+		benchmarkThreads.push_back(count);
+	}
+	if(benchmarkThreads.empty()) benchmarkThreads.push_back(threads);
+
+	// the traversal stacks and the thread contexts are allocated for the highest thread count
+	threads = *std::max_element(benchmarkThreads.begin(), benchmarkThreads.end());
+
+	const char* camarg = getArgument(argc, argv, "-cameras");
+	if(camarg) splitList(camarg, benchmarkCameras);
+	for (size_t i = 0; i < benchmarkCameras.size(); ++i)
+	{
+		ifstream cam(benchmarkCameras[i].c_str());
+		if(cam.fail())
+		{
+			std::cout << "cannot open camera file: " << benchmarkCameras[i] << endl;
+			exit(-1);
+		}
+	}
+	if(benchmarkCameras.empty()) benchmarkCameras.push_back("");
+
+	const char* warmarg = getArgument(argc, argv, "-warmup");
+	if(warmarg) benchmarkWarmup = MAX(0, atoi(warmarg));
+
+	const char* reparg = getArgument(argc, argv, "-repeat");
+	if(reparg) benchmarkRepeat = MAX(1, atoi(reparg));
+
+	const char* filearg = getArgument(argc, argv, "-benchmarkFile");
+	if(filearg) benchmarkFile = filearg;
+
+	const char* basearg = getArgument(argc, argv, "-baseline");
+	if(basearg) benchmarkBaseline = basearg;
+
+	const char* tolarg = getArgument(argc, argv, "-tolerance");
+	if(tolarg) benchmarkTolerance = MAX(0.0, atof(tolarg) / 100.0);
+}
+
+/// peak resident memory of the process in bytes. 0 if unknown.
+unsigned long getPeakResidentMemory()
+{
+#ifdef WINDOWS
+	return 0;
+#else
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	return (unsigned long)usage.ru_maxrss * 1024;	// kilobytes
+#endif
+}
+
+/// writes the results as JSON array. the file is rewritten after each configuration, so an aborted benchmark keeps its results.
+void writeBenchmarkResults(const char* filename, const std::vector<BenchmarkResult>& results)
+{
+	ofstream file(filename);
+	if(file.fail())
+	{
+		std::cout << "cannot write benchmark results to " << filename << endl;
+		return;
+	}
+
+	file << "[\n";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		results[i].printJSON(file);
+		file << (i+1 < results.size() ? ",\n" : "\n");
+	}
+	file << "]\n";
+}
+
+/// renders every combination of model, method, camera, resolution and thread count. each scene is constructed once.
+void RayTracer::runBenchmark()
+{
+	std::vector<BenchmarkResult> results;
+
+	// read before the benchmark runs, so a wrong file name does not waste the run
+	BenchmarkBaseline baseline;
+	if(!benchmarkBaseline.empty() && !baseline.load(benchmarkBaseline.c_str()))
+	{
+		std::cout << "cannot read benchmark baseline " << benchmarkBaseline << endl;
+		exit(-1);
+	}
+
+	for (currentModelFile = 0; currentModelFile < modelFileCount; ++currentModelFile)
+	{
+		for (currentMethod = 0; currentMethod < (int)methods.size(); ++currentMethod)
+		{
+			// the default camera of the model is computed for the first resolution
+			setResolution(benchmarkResolutions[0].first, benchmarkResolutions[0].second);
+			prepareRaytracing();
+
+			vec defaultPosition = camera->getPosition();
+			vec defaultDirection = camera->getDirection();
+			vec defaultUp = camera->getUp();
+
+			for (size_t c = 0; c < benchmarkCameras.size(); ++c)
+			{
+				for (size_t r = 0; r < benchmarkResolutions.size(); ++r)
+				{
+					setResolution(benchmarkResolutions[r].first, benchmarkResolutions[r].second);
+
+					if(benchmarkCameras[c].empty())
+					{
+						camera->set(defaultPosition, defaultDirection, defaultUp);
+					}
+					else
+					{
+						cameraController.loadFromFile(benchmarkCameras[c].c_str());
+						cameraController.apply(*camera);
+					}
+
+					for (size_t t = 0; t < benchmarkThreads.size(); ++t)
+					{
+						threads = benchmarkThreads[t];
+						testSetup.threads = threads;
+
+						// the previous configuration must not be displayed by the pipeline
+						frontBufferValid = false;
+
+						for (int i = 0; i < benchmarkWarmup; ++i)
+						{
+							render();
+						}
+
+						testResult.clear();
+						traversalTimeMeasurement.startAverageMeasurement(0);
+						raytraceTimeMeasurement.startAverageMeasurement(0);
+						displayTimeMeasurement.startAverageMeasurement(0);
+
+						BenchmarkResult result;
+						for (int i = 0; i < benchmarkRepeat; ++i)
+						{
+							render();
+							result.frameTimes.push_back(testResult.lastRayTraceTime);
+						}
+
+						result.model = modelFiles[currentModelFile];
+						result.method = getMethodStr(sceneType);
+						result.camera = benchmarkCameras[c].empty() ? "default" : benchmarkCameras[c];
+						result.width = width;
+						result.height = height;
+						result.threads = threads;
+						result.warmupFrames = benchmarkWarmup;
+						result.constructionTime = testSetup.constructionTime;
+						result.treeHeight = constructionDetails.height;
+						result.innerNodes = constructionDetails.innerNodes;
+						result.leafNodes = constructionDetails.leafNodes;
+						if(testSetup.hierarchyAnalyzed)
+						{
+							result.sahCost = testSetup.hierarchy.getSAHCost();
+							result.surfaceRatio = testSetup.hierarchy.meanSurfaceRatio;
+						}
+						result.nodeMemory = scene->getComputedMemoryUsage();
+						result.triangleMemory = triangles.size() * sizeof(Triangle);
+						result.peakResidentMemory = getPeakResidentMemory();
+						for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+						{
+							result.stageTimes[i] = testResult.getAverageStageTime(i);
+						}
+						for (int i = 0; testResult.eventFrames && i < PerfCounters::EVENT_COUNT; ++i)
+						{
+							if(testResult.eventAvailable[i]) result.traversalEvents[i] = testResult.getAverageTraversalEvents(i);
+						}
+						if(threads == 1)
+						{
+							// counted during the last frame. see TestResult::print
+							result.nodeTestsPerRay = 4. * double(testResult.rayNodeIntersections) / double(width*height);
+							result.triangleTestsPerRay = 4. * double(testResult.rayTriangleIntersections) / double(width*height);
+						}
+
+						std::cout << result.model << " " << result.method << " " << result.camera << " " << width << "x" << height
+							<< " threads: " << threads << " mean: " << result.getMean() << " median: " << result.getMedian()
+							<< " p95: " << result.getPercentile(95) << " p99: " << result.getPercentile(99) << endl;
+
+						results.push_back(result);
+						writeBenchmarkResults(benchmarkFile.c_str(), results);
+					}
+				}
+			}
+		}
+	}
+
+	if(!benchmarkBaseline.empty())
+	{
+		std::cout << "\ncomparison with " << benchmarkBaseline << ":\n";
+		if(baseline.compare(results, benchmarkTolerance, std::cout) > 0)
+		{
+			shutdown();
+			exit(2);
+		}
+	}
+}
+
+/// renders each model and method with 1, 2, 4, ... threads up to the thread count and prints the scaling of construction and rendering.
+/// the scene is constructed for each thread count, since the hierarchies allocate their traversal stacks per thread.
+void RayTracer::runThreadSweep()
+{
+	const int maxThreads = threads;
+	std::vector<int> threadCounts;
+	for (int count = 1; count < maxThreads; count *= 2) threadCounts.push_back(count);
+	threadCounts.push_back(maxThreads);
+
+	for (currentModelFile = 0; currentModelFile < modelFileCount; ++currentModelFile)
+	{
+		for (currentMethod = 0; currentMethod < (int)methods.size(); ++currentMethod)
+		{
+			ScalingResult result;
+			result.model = modelFiles[currentModelFile];
+			result.method = getMethodStr(sceneType);
+			result.width = width;
+			result.height = height;
+
+			for (size_t t = 0; t < threadCounts.size(); ++t)
+			{
+				threads = threadCounts[t];
+				testSetup.threads = threads;
+				omp_set_num_threads(threads);
+				prepareRaytracing();
+
+				// the previous configuration must not be displayed by the pipeline
+				frontBufferValid = false;
+
+				// the measurements pause the traversal timer per packet with one thread only, which would slow down the
+				// reference row. all rows are rendered without them and the frames are timed here.
+				bool stats = makeStats;
+				makeStats = false;
+
+				// warmup
+				render();
+
+				std::vector<double> frameTimes;
+				unsigned long secondaryRays = 0;
+				for (unsigned long i = 0; i < MAX(1ul, framesPerTest); ++i)
+				{
+					for (int c = 0; c < threads; ++c) threadContexts[c]->secondaryRays = 0;
+
+					TimeMeasurement frameTime;
+					render();
+					frameTimes.push_back(frameTime.getCurrentTime());
+
+					for (int c = 0; c < threads; ++c) secondaryRays += threadContexts[c]->secondaryRays;
+				}
+				std::sort(frameTimes.begin(), frameTimes.end());
+
+				makeStats = stats;
+
+				ScalingResult::Row row;
+				row.threads = threads;
+				row.constructionTime = testSetup.constructionTime;
+				row.frameTime = frameTimes[frameTimes.size() / 2];
+				row.raysPerFrame = double(width) * height + double(secondaryRays) / frameTimes.size();
+				result.rows.push_back(row);
+			}
+
+			result.print(std::cout);
+			ofstream fil("testresults/scaling.txt", ios_base::app);
+			result.print(fil);
+			fil.close();
+		}
+	}
+}
+
+/// changes the image size in benchmark mode. the camera keeps its position and direction.
+void RayTracer::setResolution(int width, int height)
+{
+	assert(headless);
+	if(width == this->width && height == this->height) return;
+
+	this->width = width;
+	this->height = height;
+
+	delete openglImage;
+	openglImage = new MemoryImage(width, height);
+	renderTarget = openglImage;
+
+	if(pipeline)
+	{
+		delete frameBuffers[0];
+		delete frameBuffers[1];
+		frameBuffers[0] = new MemoryImage(width, height);
+		frameBuffers[1] = new MemoryImage(width, height);
+		frontBufferValid = false;
+	}
+
+	Camera* resized = new Camera(width, height, camera->getFov(), camera->getPosition(), camera->getDirection(), camera->getUp());
+	delete camera;
+	camera = resized;
+}
+
+/// publishes the values of the last frame to the live metrics segment. stageTimes is NULL without measurements
+void RayTracer::publishMetrics(double frameTime, const double* stageTimes)
+{
+	LiveMetricsValues values;
+	memset(&values, 0, sizeof(values));
+
+	values.frameTime = frameTime;
+	values.rays = (unsigned long)width * height;
+	if(stageTimes)
+	{
+		for (int i = 0; i < threads; ++i) values.rays += threadContexts[i]->secondaryRays;
+		for (int s = 0; s < StageTimer::STAGE_COUNT; ++s) values.stageTimes[s] = stageTimes[s];
+		values.nodeTests = threads == 1 ? testResult.rayNodeIntersections : 0;
+		values.triangleTests = threads == 1 ? Triangle::intersectionTestsPerformed : 0;
+	}
+	values.nodeMemory = scene ? scene->getComputedMemoryUsage() : 0;
+	values.width = width;
+	values.height = height;
+	values.threads = threads;
+
+	const char* modelFileName = modelFiles[currentModelFile];
+	while(strstr(modelFileName, "/")) modelFileName = strstr(modelFileName, "/")+1;	// extract file name
+	strncpy(values.model, modelFileName, sizeof(values.model)-1);
+	strncpy(values.method, getMethodStr(sceneType), sizeof(values.method)-1);
+
+	liveMetrics.publish(values);
+}
+
+/// writes the timeline. registered with atexit, since test and video mode end with exit.
+void RayTracer::writeTrace()
+{
+	TraceRecorder& trace = getInstance().trace;
+	if(trace.write())
+	{
+		std::cout << "wrote timeline to " << trace.getFileName() << endl;
+	}
+	else
+	{
+		std::cout << "cannot write timeline to " << trace.getFileName() << endl;
+	}
+}
+
 void RayTracer::shutdown()
 {
 	delete scene;
 	delete camera;
+	delete frameCamera;
 	delete openglImage;
+	delete frameBuffers[0];
+	delete frameBuffers[1];
+	for (size_t i = 0; i < threadContexts.size(); ++i)
+	{
+		delete threadContexts[i];
+	}
+	threadContexts.clear();
 }
 
+#ifndef HEADLESS
 /// called whenever the window size changes
 void RayTracer::changeSize ( GLsizei w, GLsizei h )
 {
@@ -1485,6 +2749,7 @@ void RayTracer::changeSize ( GLsizei w, GLsizei h )
 	glMatrixMode ( GL_MODELVIEW );
 	glLoadIdentity();
 }
+#endif
 
 /// called whenever a key is pressed
 void RayTracer::keyboard ( unsigned char key, int , int )
@@ -1544,6 +2809,10 @@ void RayTracer::keyboard ( unsigned char key, int , int )
 			// toggle scene background
 			background = !background;
 			break;
+		case 'h':
+			// shaded image -> node heatmap -> triangle heatmap
+			heatmap = (HEATMAP)((heatmap + 1) % 3);
+			break;
 		case 'p':
 		{
 			// save image
@@ -1584,30 +2853,18 @@ void RayTracer::mouseMotion ( int x, int y )
 /// creates a new shadow ray and enqueues it in the renderer
 void RayTracer::createShadowRay(const qvec& origin, const qvec& direction, const qfloat& length, const qvec& color, const quad<vec*>& destination)
 {
-	#ifdef MULTITHREADING
-		// each thread owns an array to prevent threads from interfering each other
-		int thread = omp_get_thread_num();
-		shadowRays[thread].resize(shadowRays[thread].size()+1);
-		ShadowRay& shadowRay = shadowRays[thread][shadowRays[thread].size()-1];
-	#else
-		shadowRays.resize(shadowRays.size()+1);
-		ShadowRay& shadowRay = shadowRays[shadowRays.size()-1];
-	#endif
+	// each thread owns an arena to prevent threads from interfering each other
+	ShadowRay& shadowRay = getShadowRays(omp_get_thread_num()).push();
 
 	static qfloat BIAS(sceneSize / 100.f);
 
-	// TODO use placement new operator with a preallocated heap to avoid thread synchronization and OS overhead
-
-	shadowRay.destination = new quad<vec*>();
-	*shadowRay.destination = destination;
-	shadowRay.color = new qvec();
-	*shadowRay.color = color;
-	shadowRay.ray = new PackedRay();
-	shadowRay.ray->origin = origin + direction * BIAS;
-	shadowRay.ray->hit = NULL;
-	shadowRay.ray->dir = direction;
-	shadowRay.ray->dirrcp = qvec(qfloat(1.0f)) / direction;
-	shadowRay.ray->t = length - BIAS;
+	shadowRay.destination = destination;
+	shadowRay.color = color;
+	shadowRay.ray.origin = origin + direction * BIAS;
+	shadowRay.ray.hit = NULL;
+	shadowRay.ray.dir = direction;
+	shadowRay.ray.dirrcp = qvec(qfloat(1.0f)) / direction;
+	shadowRay.ray.t = length - BIAS;
 }
 
 /// creates a new shadow ray and enqueues it in the renderer
@@ -1615,19 +2872,14 @@ void RayTracer::castShadowRay(const qvec& origin, const qvec& direction, const q
 {
 	static qfloat BIAS(sceneSize / 100.f);
 
-	// TODO use placement new operator with a preallocated heap to avoid thread synchronization and OS overhead
-
 	ShadowRay shadowRay;
-	shadowRay.destination = new quad<vec*>();
-	*shadowRay.destination = destination;
-	shadowRay.color = new qvec();
-	*shadowRay.color = color;
-	shadowRay.ray = new PackedRay();
-	shadowRay.ray->origin = origin + direction * BIAS;
-	shadowRay.ray->hit = NULL;
-	shadowRay.ray->dir = direction;
-	shadowRay.ray->dirrcp = qvec(qfloat(1.0f)) / direction;
-	shadowRay.ray->t = length - BIAS;
+	shadowRay.destination = destination;
+	shadowRay.color = color;
+	shadowRay.ray.origin = origin + direction * BIAS;
+	shadowRay.ray.hit = NULL;
+	shadowRay.ray.dir = direction;
+	shadowRay.ray.dirrcp = qvec(qfloat(1.0f)) / direction;
+	shadowRay.ray.t = length - BIAS;
 
 	castShadowRay(shadowRay);
 }
@@ -1635,28 +2887,20 @@ void RayTracer::castShadowRay(const qvec& origin, const qvec& direction, const q
 /// creates a new reflection/refraction ray and enqueues it in the renderer
 void RayTracer::createRefxxctionRay(const qvec& origin, const qvec& direction, const quad<vec*>& destination, int level, const qvec& contribution)
 {
-	#ifdef MULTITHREADING
-		// each thread owns an array to prevent threads from interfering each other
-		int thread = omp_get_thread_num();
-		refxxctionRays[thread]->resize(refxxctionRays[thread]->size()+1);
-		RefxxctionRay& refxxctionRay = (*refxxctionRays[thread])[refxxctionRays[thread]->size()-1];
-	#else
-		refxxctionRays->resize(refxxctionRays->size()+1);
-		RefxxctionRay& refxxctionRay = (*refxxctionRays)[refxxctionRays->size()-1];
-	#endif
+	// each thread owns an arena to prevent threads from interfering each other
+	RefxxctionRay& refxxctionRay = getRefxxctionRays(omp_get_thread_num())->push();
 
 	static qfloat BIAS(sceneSize / 500.f);
 
-	refxxctionRay.destination = new quad<vec*>();
-	*refxxctionRay.destination = destination;
-	refxxctionRay.contribution = new qvec(contribution);
+	refxxctionRay.destination = destination;
+	refxxctionRay.contribution = contribution;
 	refxxctionRay.level = level;
-	refxxctionRay.ray = new PackedRay();
-	refxxctionRay.ray->origin = origin + direction * BIAS;
-	refxxctionRay.ray->hit = NULL;
-	refxxctionRay.ray->dir = direction;
-	refxxctionRay.ray->dirrcp = qvec(qfloat(1.0f)) / direction;
-	refxxctionRay.ray->t = HUGE_VAL;
+	refxxctionRay.repacked = false;
+	refxxctionRay.ray.origin = origin + direction * BIAS;
+	refxxctionRay.ray.hit = NULL;
+	refxxctionRay.ray.dir = direction;
+	refxxctionRay.ray.dirrcp = qvec(qfloat(1.0f)) / direction;
+	refxxctionRay.ray.t = HUGE_VAL;
 }
 
 /// creates a new reflection/refraction ray and enqueues it in the renderer
@@ -1665,16 +2909,15 @@ void RayTracer::castRefxxctionRay(const qvec& origin, const qvec& direction, con
 	static qfloat BIAS(sceneSize / 500.f);
 
 	RefxxctionRay refxxctionRay;
-	refxxctionRay.destination = new quad<vec*>();
-	*refxxctionRay.destination = destination;
-	refxxctionRay.contribution = new qvec(contribution);
+	refxxctionRay.destination = destination;
+	refxxctionRay.contribution = contribution;
 	refxxctionRay.level = level;
-	refxxctionRay.ray = new PackedRay();
-	refxxctionRay.ray->origin = origin + direction * BIAS;
-	refxxctionRay.ray->hit = NULL;
-	refxxctionRay.ray->dir = direction;
-	refxxctionRay.ray->dirrcp = qvec(qfloat(1.0f)) / direction;
-	refxxctionRay.ray->t = HUGE_VAL;
+	refxxctionRay.repacked = false;
+	refxxctionRay.ray.origin = origin + direction * BIAS;
+	refxxctionRay.ray.hit = NULL;
+	refxxctionRay.ray.dir = direction;
+	refxxctionRay.ray.dirrcp = qvec(qfloat(1.0f)) / direction;
+	refxxctionRay.ray.t = HUGE_VAL;
 
 	castRefxxctionRay(refxxctionRay);
 }
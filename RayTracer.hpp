@@ -9,7 +9,9 @@
 #define _RAYTRACER_H_
 
 //#include <GL/glut.h>
+#ifndef HEADLESS
 #include <GL/glew.h>
+#endif
 
 #include <iostream>
 #include <fstream>
@@ -26,10 +28,20 @@
 #include "Image.hpp"
 #include "ShadowRay.hpp"
 #include "RefxxctionRay.hpp"
+#include "RayArena.hpp"
+#include "RayQueueSorter.hpp"
+#include "TileScheduler.hpp"
+#include "RecordingScene.hpp"
+#include "TraceRecorder.hpp"
+#include "LiveMetrics.hpp"
 
 #include "TimeMeasurement.hpp"
+#include "StageTimer.hpp"
 #include "TestSetup.hpp"
 #include "TestResult.hpp"
+#include "BenchmarkResult.hpp"
+#include "BenchmarkBaseline.hpp"
+#include "ScalingResult.hpp"
 
 
 
@@ -41,42 +53,103 @@ public:
 	{
 		TEST,
 		INTERACTIVE,
-		VIDEO
+		VIDEO,
+		BENCHMARK
+	};
+
+	enum HEATMAP
+	{
+		NO_HEATMAP,
+		NODE_HEATMAP,	// node visits per primary ray
+		TRIANGLE_HEATMAP	// triangle tests per primary ray
 	};
 
 private:
 	IOpenGLImage* openglImage;
+	bool headless;	// render without window and OpenGL. set by command line argument or by HEADLESS build.
 	int width;
 	int height;
 	Camera* camera;
+	Camera* frameCamera;	// snapshot of the camera for the frame in flight. input changes the camera only and is applied to the next frame.
 	CameraController cameraController;
 	float cameraSpeed;
 	vector<Triangle> triangles;
 	vector<Light*> lights;
 	bool shadows;
 
-	/// shadow rays are traversed in a separate pass to make Frustum Tracing possible
-	#ifdef MULTITHREADING
-		vector<ShadowRay> shadowRays[THREAD_COUNT];
-	#else
-		vector<ShadowRay> shadowRays;
-	#endif
-
-	/// reflection/refraction rays are traversed in a separate pass to make Frustum Tracing possible
-	#ifdef MULTITHREADING
-		vector<RefxxctionRay> refxxctionRaysA[THREAD_COUNT];
-		vector<RefxxctionRay> refxxctionRaysB[THREAD_COUNT];
-		vector<RefxxctionRay>* refxxctionRays[THREAD_COUNT];
-	#else
-		vector<RefxxctionRay> refxxctionRaysA;
-		vector<RefxxctionRay> refxxctionRaysB;
-		vector<RefxxctionRay>* refxxctionRays;
-	#endif
+	/// state of a render thread. each context is allocated separately and aligned to cache lines, so threads do not share cache lines.
+	struct ThreadContext : public memAligned<CACHE_LINE_SIZE>
+	{
+		/// shadow rays are traversed in a separate pass to make Frustum Tracing possible
+		RayArena<ShadowRay> shadowRays;
+
+		/// reflection/refraction rays are traversed in a separate pass to make Frustum Tracing possible
+		RayArena<RefxxctionRay> refxxctionRaysA;
+		RayArena<RefxxctionRay> refxxctionRaysB;
+		RayArena<RefxxctionRay>* refxxctionRays;
+
+		/// time per render stage of the current frame
+		StageTimer stageTimer;
+
+		/// hardware events of the thread. attached to the stage timer if they could be opened.
+		PerfCounters perfCounters;
+
+		/// shadow and reflection/refraction rays traced in the current frame. reset with the stage timers.
+		unsigned long secondaryRays;
+
+		char padding[CACHE_LINE_SIZE];	// keeps the next allocation off the last cache line
+
+		ThreadContext() : refxxctionRays(&refxxctionRaysA), secondaryRays(0) {}
+	};
+	std::vector<ThreadContext*> threadContexts;
+	int threads;	// number of render threads. set by command line argument.
+	bool countEvents;	// hardware event counters per thread and stage. set by command line argument.
+
+	/// secondary ray queues are sorted by origin and direction and repacked to full packets before they are traversed. set by command line argument.
+	bool sortSecondaryRays;
+	RayQueueSorter rayQueueSorter;
+
+	/// distributes the image tiles among the threads. the tile size is set by command line argument.
+	TileScheduler tileScheduler;
+	int tileSize;
+
+	/// secondary rays are traced per frame by all threads instead of per tile. set by command line argument.
+	bool globalSecondaryPasses;
+	/// shared state of the global secondary ray passes
+	std::vector<RayArena<ShadowRay>*> secondaryShadowQueues;
+	std::vector<RayArena<RefxxctionRay>*> secondaryRefxxctionQueues;
+	int secondaryRayCount;
+
+	/// frames are pipelined: the threads trace the next frame into a back buffer while the master thread displays the previous one. set by command line argument.
+	bool pipeline;
+	IOpenGLImage* frameBuffers[2];
+	int backBuffer;	// index of the frame buffer which is traced
+	bool frontBufferValid;	// the front buffer holds a traced frame which has not been displayed yet
+	IOpenGLImage* renderTarget;	// image the threads shade into. the back buffer or openglImage if pipelining is off
+
+	/// traversal cost of the primary rays is shown as false colour image instead of the shaded image. set by command line argument or key h.
+	HEATMAP heatmap;
+	std::vector<unsigned int> heatmapCounts;	// per pixel of the current frame
+	unsigned int heatmapMaximum;	// of the last drawn heatmap. red in the image.
+
+	/// the rays of the first frame are written to a file for rayreplay. set by command line argument.
+	std::string rayRecordFile;
+	RecordingScene* rayRecorder;	// decorates scene until the rays are recorded. NULL otherwise.
+
+	/// timeline of the threads. written when the program exits. enabled by command line argument.
+	TraceRecorder trace;
+	static void writeTrace();
+
+	/// metrics of each frame for monitoring processes. enabled by command line argument.
+	LiveMetrics liveMetrics;
+	void publishMetrics(double frameTime, const double* stageTimes);
 
 	Scene* scene;
 	float sceneSize;	// max aabb extend of scene
 	int currentMethod;
 	std::vector<SCENE_TYPE> methods;
+	SCENE_TYPE sceneType;	// type of the current scene. methods[currentMethod] unless that is AUTO.
+	unsigned long memoryBudget;	// bytes of the acceleration structure for the automatic selection and the hybrid hierarchy. 0 for no limit. set by command line argument.
 	MODE mode;
 	TestSetup testSetup;
 	TestResult testResult;
@@ -93,17 +166,35 @@ private:
 	TimeMeasurement traversalTimeMeasurement;
 	TimeMeasurement raytraceTimeMeasurement;
 	TimeMeasurement displayTimeMeasurement;
+	SceneConstructionDetails constructionDetails;	// of the current scene
+
+	/// configurations of the benchmark mode. set by command line arguments.
+	std::vector<std::string> benchmarkCameras;	// camera files. empty string for the default camera of the model.
+	std::vector< std::pair<int,int> > benchmarkResolutions;
+	std::vector<int> benchmarkThreads;
+	int benchmarkWarmup;	// frames rendered before the measurement
+	int benchmarkRepeat;	// measured frames
+	std::string benchmarkFile;	// JSON output
+	std::string benchmarkBaseline;	// JSON output of an earlier run to compare with. empty for no comparison.
+	double benchmarkTolerance;	// relative
+
+	/// test mode renders each model and method with 1, 2, 4, ... threads and prints the scaling. set by command line argument.
+	bool threadSweep;
 
 	RayTracer();
 
+#ifndef HEADLESS
 	void changeSize(GLsizei w, GLsizei h);
+#endif
 	void idle();
 	void keyboard(unsigned char key, int , int );
 	void mouse(int button, int state, int x, int y);
 	void mouseMotion(int x, int y);
 
 	/// callbacks for glut
+#ifndef HEADLESS
 	static void changeSizeCallback(GLsizei w, GLsizei h);
+#endif
 	static void idleCallback();
 	static void keyboardCallback(unsigned char key, int , int );
 	static void mouseCallback(int button, int state, int x, int y);
@@ -111,12 +202,33 @@ private:
 	static void renderCallback();
 
 	void init(int argc, char** argv);
+#ifndef HEADLESS
 	void initGL(int argc, char** argv);
+#endif
 	void createImage(int argc, char** argv);
 	void render();
+	void renderTile(const TileScheduler::Tile& tile);
+	void presentFrame(IOpenGLImage* frame);
+	void storeHeatmapCounts(const LaneCounters& lanes, int x, int y);
+	void drawHeatmap();
+	void traceSecondaryRays(int thread);
+	void traceSecondaryRaysGlobal();
+	void createThreadContexts();
+	RayArena<ShadowRay>& getShadowRays(int thread);
+	RayArena<RefxxctionRay>*& getRefxxctionRays(int thread);
+	RayArena<RefxxctionRay>* swapRefxxctionRays(int thread);
+	int getQueueCount() const;
+	StageTimer* getStageTimer(int thread);
+	void shadePrimaryRays(PackedRay& r, int x, int y);
 	void shutdown();
+	void parseBenchmarkArguments(int argc, char** argv);
+	void runBenchmark();
+	void runThreadSweep();
+	void setResolution(int width, int height);
 
 	SceneConstructionDetails createScene(SCENE_TYPE type);
+	SceneConstructionDetails selectScene(const SceneConstructionDetails& details);
+	double probeScene();
 	void prepareRaytracing();
 	void printTestResults();
 
@@ -125,7 +237,7 @@ public:
 	
 	void castShadowRay(ShadowRay& sray);
 	void castRefxxctionRay(RefxxctionRay& sray);
-	void castRefxxctionRay(vector<RefxxctionRay>& refxxctionRays);
+	void castRefxxctionRay(RayArena<RefxxctionRay>& refxxctionRays);
 
 	void run(int argc, char** argv, unsigned int width, unsigned int height);
 
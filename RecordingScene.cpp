@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include <cassert>
+
+#include "RecordingScene.hpp"
+
+static const char RAY_DUMP_MAGIC[8] = { 'S', 'S', 'H', 'R', 'A', 'Y', 'S', '1' };
+
+RecordingScene::RecordingScene(Scene* scene) : scene(scene), triangles(NULL), recording(false)
+{
+	assert(scene);
+}
+
+RecordingScene::~RecordingScene()
+{
+	for (size_t i = 0; i < threadRecords.size(); ++i)
+	{
+		delete threadRecords[i];
+	}
+	delete scene;
+}
+
+SceneConstructionDetails RecordingScene::construct(std::vector<Triangle>* geometries)
+{
+	triangles = geometries;
+	return scene->construct(geometries);
+}
+
+IntersectDetails RecordingScene::intersect(PackedRay& ray)
+{
+	if(!recording) return scene->intersect(ray);
+
+	RayRecord& r = record(ray);
+	IntersectDetails result = scene->intersect(ray);
+	r.t = ray.t;
+	return result;
+}
+
+void RecordingScene::intersectPackets(PackedRay** rays, unsigned int count, IntersectDetails& out)
+{
+	if(!recording)
+	{
+		scene->intersectPackets(rays, count, out);
+		return;
+	}
+
+	// the packets are passed on together, so interleaved traversal is recorded as it is rendered.
+	// arena records keep their addresses while more records are added.
+	const unsigned int CHUNK = 64;
+	RayRecord* records[CHUNK];
+	for (unsigned int first = 0; first < count; first += CHUNK)
+	{
+		unsigned int chunk = count - first < CHUNK ? count - first : CHUNK;
+		for (unsigned int i = 0; i < chunk; ++i)
+		{
+			records[i] = &record(*rays[first + i]);
+		}
+
+		scene->intersectPackets(rays + first, chunk, out);
+
+		for (unsigned int i = 0; i < chunk; ++i)
+		{
+			records[i]->t = rays[first + i]->t;
+		}
+	}
+}
+
+void RecordingScene::start()
+{
+	int threadCount = omp_get_max_threads();
+	while((int)threadRecords.size() < threadCount)
+	{
+		threadRecords.push_back(new ThreadRecords());
+	}
+
+	for (size_t i = 0; i < threadRecords.size(); ++i)
+	{
+		threadRecords[i]->records.clear();
+		threadRecords[i]->kind = PRIMARY;
+	}
+
+	recording = true;
+}
+
+unsigned long RecordingScene::getRecordCount() const
+{
+	unsigned long count = 0;
+	for (size_t i = 0; i < threadRecords.size(); ++i)
+	{
+		count += threadRecords[i]->records.size();
+	}
+	return count;
+}
+
+bool RecordingScene::save(const char* fileName) const
+{
+	assert(triangles);
+
+	FILE* file = fopen(fileName, "wb");
+	if(!file) return false;
+
+	RayDumpHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RAY_DUMP_MAGIC, sizeof(header.magic));
+	header.triangleSize = sizeof(Triangle);
+	header.recordSize = sizeof(RayRecord);
+	header.triangleCount = triangles->size();
+	header.recordCount = getRecordCount();
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	if(ok && !triangles->empty())
+	{
+		ok = fwrite(&(*triangles)[0], sizeof(Triangle), triangles->size(), file) == triangles->size();
+	}
+
+	// the records of the threads one after another
+	for (size_t t = 0; ok && t < threadRecords.size(); ++t)
+	{
+		RayArena<RayRecord>& records = threadRecords[t]->records;
+		for (size_t i = 0; ok && i < records.size(); ++i)
+		{
+			ok = fwrite(&records[i], sizeof(RayRecord), 1, file) == 1;
+		}
+	}
+
+	if(fclose(file) != 0) ok = false;
+	return ok;
+}
+
+bool RecordingScene::load(const char* fileName, std::vector<Triangle>& triangles, RayArena<RayRecord>& records)
+{
+	FILE* file = fopen(fileName, "rb");
+	if(!file) return false;
+
+	RayDumpHeader header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, RAY_DUMP_MAGIC, sizeof(header.magic)) == 0
+		&& header.triangleSize == sizeof(Triangle)
+		&& header.recordSize == sizeof(RayRecord);
+
+	triangles.clear();
+	if(ok) triangles.reserve(header.triangleCount);
+	for (unsigned long i = 0; ok && i < header.triangleCount; ++i)
+	{
+		// Triangle has no default constructor. the material pointers of the writer are meaningless here.
+		vec zero(0,0,0);
+		Triangle triangle(NULL, zero, zero, zero, zero, zero, zero, zero, zero, zero);
+		ok = fread(&triangle, sizeof(Triangle), 1, file) == 1;
+		triangle.material = NULL;
+		if(ok) triangles.push_back(triangle);
+	}
+
+	records.clear();
+	for (unsigned long i = 0; ok && i < header.recordCount; ++i)
+	{
+		ok = fread(&records.push(), sizeof(RayRecord), 1, file) == 1;
+	}
+
+	fclose(file);
+	return ok;
+}
+
+const char* RecordingScene::getKindName(int kind)
+{
+	switch(kind)
+	{
+	case PRIMARY: return "primary";
+	case SHADOW: return "shadow";
+	case REFXXCTION: return "reflection/refraction";
+	}
+	return "unknown";
+}
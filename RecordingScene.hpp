@@ -0,0 +1,107 @@
+#ifndef RECORDINGSCENE_HPP
+#define RECORDINGSCENE_HPP
+
+#include <vector>
+
+#include "MultiThreading.hpp"
+#include "Scene.hpp"
+#include "RayArena.hpp"
+
+/// a ray packet passed to Scene::intersect and its result
+struct RayRecord : public SIMDmemAligned
+{
+	PackedRay ray;	// as passed to the scene. the hit pointers are cleared.
+	qfloat t;	// distance after the intersection. unchanged for lanes without hit.
+	int kind;	// RecordingScene::RAY_KIND
+};
+
+/// header of a ray dump file. the triangles and records follow as raw memory, so a dump can only be read by the build which wrote it.
+struct RayDumpHeader
+{
+	char magic[8];
+	unsigned int triangleSize;	// sizeof(Triangle) of the writer
+	unsigned int recordSize;	// sizeof(RayRecord) of the writer
+	unsigned long triangleCount;
+	unsigned long recordCount;
+};
+
+/*
+	decorator which records every ray packet passed to the decorated scene during a frame.
+	the dump holds the triangles and the rays, so the replay tool (rayreplay.cpp) can build any acceleration structure
+	and trace the identical ray stream without camera, shading and display.
+	each thread records into its own arena, so recording needs no synchronization.
+*/
+class RecordingScene : public Scene
+{
+public:
+	enum RAY_KIND
+	{
+		PRIMARY,
+		SHADOW,
+		REFXXCTION,
+		KIND_COUNT
+	};
+
+	/// takes ownership of scene
+	RecordingScene(Scene* scene);
+	virtual ~RecordingScene();
+
+	virtual SceneConstructionDetails construct(std::vector<Triangle>* geometries);
+	virtual IntersectDetails intersect(PackedRay& ray);
+	virtual void intersectPackets(PackedRay** rays, unsigned int count, IntersectDetails& out);
+	virtual const AABBox& getBounds() const { return scene->getBounds(); }
+	virtual unsigned long getComputedMemoryUsage() const { return scene->getComputedMemoryUsage(); }
+	virtual bool analyze(HierarchyStatistics& out) { return scene->analyze(out); }
+	virtual bool setAccessTrace(NodeAccessTrace* trace) { return scene->setAccessTrace(trace); }
+
+	/// discards the previous records and records the rays of the next omp_get_max_threads() threads
+	void start();
+	void stop() { recording = false; }
+	bool isRecording() const { return recording; }
+
+	/// kind of the rays the calling thread passes to the scene next
+	void setKind(RAY_KIND kind)
+	{
+		if(recording) threadRecords[omp_get_thread_num()]->kind = kind;
+	}
+
+	unsigned long getRecordCount() const;
+
+	/// writes the triangles and the records of all threads. returns false if the file could not be written.
+	bool save(const char* fileName) const;
+
+	/// reads a dump. returns false if the file could not be read or was written by another build.
+	static bool load(const char* fileName, std::vector<Triangle>& triangles, RayArena<RayRecord>& records);
+
+	static const char* getKindName(int kind);
+
+private:
+	Scene* scene;
+	std::vector<Triangle>* triangles;
+	bool recording;
+
+	// records of one thread. aligned to cache lines, so threads do not share cache lines.
+	struct ThreadRecords : public memAligned<CACHE_LINE_SIZE>
+	{
+		RayArena<RayRecord> records;
+		int kind;
+		char padding[CACHE_LINE_SIZE];
+	};
+	std::vector<ThreadRecords*> threadRecords;
+
+	inline RayRecord& record(const PackedRay& ray)
+	{
+		ThreadRecords& thread = *threadRecords[omp_get_thread_num()];
+		RayRecord& record = thread.records.push();
+		record.ray = ray;
+		record.ray.hit = (Triangle*)NULL;
+		record.kind = thread.kind;
+		return record;
+	}
+
+	// not copyable
+	RecordingScene(const RecordingScene&);
+	RecordingScene& operator=(const RecordingScene&);
+};
+
+#endif
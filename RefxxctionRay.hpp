@@ -4,15 +4,18 @@
 #include "vecmath.h"
 #include "Ray.hpp"
 
-struct RefxxctionRay
+struct RefxxctionRay : public SIMDmemAligned
 {
-	PackedRay* ray;
+	PackedRay ray;
 
-	quad<vec*>* destination;
+	quad<vec*> destination;
 
-	qvec* contribution;
+	qvec contribution;
 
 	int level;
+
+	/// the lanes come from different packets and are shaded separately
+	bool repacked;
 };
 
 #endif
\ No newline at end of file
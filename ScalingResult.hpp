@@ -0,0 +1,66 @@
+#ifndef _SCALINGRESULT_H_
+#define _SCALINGRESULT_H_
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+/// construction and frame time of one model and method at increasing thread counts. printed as table.
+struct ScalingResult
+{
+	std::string model;
+	std::string method;
+	int width;
+	int height;
+
+	struct Row
+	{
+		int threads;
+		double constructionTime;
+		double frameTime;	// median of the measured frames
+		double raysPerFrame;	// primary and secondary rays
+	};
+	std::vector<Row> rows;	// the first row is the reference of the speedups
+
+	ScalingResult() : width(0), height(0) {}
+
+	void print(std::ostream& stream) const
+	{
+		stream << "thread scaling of " << model << " " << method << " " << width << "x" << height << ":\n"
+			<< std::setw(8) << "threads"
+			<< std::setw(14) << "construction"
+			<< std::setw(9) << "speedup"
+			<< std::setw(11) << "efficiency"
+			<< std::setw(12) << "frame"
+			<< std::setw(9) << "speedup"
+			<< std::setw(11) << "efficiency"
+			<< std::setw(10) << "Mrays/s"
+			<< std::setw(16) << "Mrays/s/core" << "\n";
+
+		if(rows.empty()) return;
+		const Row& reference = rows[0];
+		for (size_t i = 0; i < rows.size(); ++i)
+		{
+			const Row& row = rows[i];
+
+			// speedup relative to the reference row. efficiency is the speedup per additional thread factor.
+			double threadFactor = double(row.threads) / reference.threads;
+			double constructionSpeedup = row.constructionTime > 0.0 ? reference.constructionTime / row.constructionTime : 0.0;
+			double frameSpeedup = row.frameTime > 0.0 ? reference.frameTime / row.frameTime : 0.0;
+			double mrays = row.frameTime > 0.0 ? row.raysPerFrame / row.frameTime / 1e6 : 0.0;
+
+			stream << std::setw(8) << row.threads
+				<< std::setw(14) << row.constructionTime
+				<< std::setw(9) << constructionSpeedup
+				<< std::setw(11) << constructionSpeedup / threadFactor
+				<< std::setw(12) << row.frameTime
+				<< std::setw(9) << frameSpeedup
+				<< std::setw(11) << frameSpeedup / threadFactor
+				<< std::setw(10) << mrays
+				<< std::setw(16) << mrays / row.threads << "\n";
+		}
+	}
+};
+
+#endif
@@ -9,15 +9,21 @@
 
 #include "SceneConstructionDetails.hpp"
 #include "IntersectDetails.hpp"
+#include "HierarchyStatistics.hpp"
 
 #include "Triangle.hpp"
 
+class NodeAccessTrace;
+
 enum SCENE_TYPE
 {
 	BVH,
 	SSH,
+	DSH,	// dual slab hierarchy
+	HYBRID,	// SSH with box nodes (HybridHierarchy)
 	KD,
-	SIMPLE
+	SIMPLE,
+	AUTO	// chosen per model by a probe of the other types (RayTracer::selectScene)
 };
 
 class Scene
@@ -26,8 +32,24 @@ class Scene
 	virtual ~Scene() {}
 	virtual SceneConstructionDetails construct(std::vector<Triangle>* geometries) = 0;
 	virtual IntersectDetails intersect(PackedRay&) = 0;
+
+	/// intersects several ray packets. acceleration structures can override this to traverse the packets interleaved.
+	virtual void intersectPackets(PackedRay** rays, unsigned int count, IntersectDetails& out)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			out.rayNodeIntersections += intersect(*rays[i]).rayNodeIntersections;
+		}
+	}
 	virtual const AABBox& getBounds() const = 0;
 	virtual unsigned long getComputedMemoryUsage() const = 0;
+
+	/// quality statistics of the acceleration structure. returns false if the scene has none.
+	virtual bool analyze(HierarchyStatistics&) { return false; }
+
+	/// logs the nodes and triangles the traversal touches into trace until it is called with NULL.
+	/// returns false if the scene has no nodes. the traced packets have to be intersected by one thread.
+	virtual bool setAccessTrace(NodeAccessTrace*) { return false; }
 };
 
 #endif
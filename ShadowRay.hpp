@@ -4,15 +4,15 @@
 #include "vecmath.h"
 #include "Ray.hpp"
 
-struct ShadowRay
+struct ShadowRay : public SIMDmemAligned
 {
-	PackedRay* ray;
+	PackedRay ray;
 
 	/// color is the light contribution.
 	/// will be added to destination if the ray doesn't hit any geometry
-	qvec* color;
+	qvec color;
 
-	quad<vec*>* destination;
+	quad<vec*> destination;
 };
 
 #endif
\ No newline at end of file
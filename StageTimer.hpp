@@ -0,0 +1,157 @@
+#ifndef STAGETIMER_HPP
+#define STAGETIMER_HPP
+
+#include <stdio.h>
+
+#include "TimeMeasurement.hpp"
+#include "PerfCounters.hpp"
+
+// reflection/refraction bounces with their own stage. deeper bounces are added to the last one.
+#define STAGE_TIMER_LEVELS 8
+
+/*
+	exclusive time per render stage of one thread.
+	the stages are nested (e.g. shading casts shadow rays), so entering a stage stops the clock of the enclosing stage and
+	leaving it continues the enclosing stage. time outside of all stages (tile scheduling, waiting at barriers) is OTHER.
+	each thread has its own timer, so the timers need no synchronization.
+	if hardware counters are attached, their events are charged to the stages like the time. this costs a counter read per switch.
+*/
+class StageTimer
+{
+public:
+	enum STAGE
+	{
+		OTHER,
+		CLEAR,	// framebuffer clear
+		CAMERA_RAYS,	// primary ray generation
+		PRIMARY_TRAVERSAL,
+		SHADING,
+		SHADOW_TRAVERSAL,
+		SORTING,	// secondary ray queue sorting
+		REFXXCTION_TRAVERSAL,	// first bounce. bounce n is REFXXCTION_TRAVERSAL + n-1
+		CONVERT = REFXXCTION_TRAVERSAL + STAGE_TIMER_LEVELS,	// framebuffer copy and upload
+		DISPLAY,
+		STAGE_COUNT
+	};
+
+	double seconds[STAGE_COUNT];
+	double events[STAGE_COUNT][PerfCounters::EVENT_COUNT];	// 0 without counters
+
+	StageTimer() : counters(NULL)
+	{
+		beginFrame();
+	}
+
+	/// counters of the thread of the timer. NULL detaches them.
+	void attach(const PerfCounters* counters)
+	{
+		this->counters = counters;
+	}
+
+	const PerfCounters* getCounters() const { return counters; }
+
+	void beginFrame()
+	{
+		for (int i = 0; i < STAGE_COUNT; ++i)
+		{
+			seconds[i] = 0.0;
+			for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) events[i][e] = 0.0;
+		}
+		current = OTHER;
+		last = TimeMeasurement::now();
+		if(counters) counters->read(lastEvents);
+	}
+
+	/// charges the time since the last switch to the current stage
+	void endFrame()
+	{
+		switchTo(current);
+	}
+
+	/// starts a stage and returns the enclosing stage, which has to be passed to leave
+	int enter(int stage)
+	{
+		int enclosing = current;
+		switchTo(stage);
+		return enclosing;
+	}
+
+	void leave(int enclosing)
+	{
+		switchTo(enclosing);
+	}
+
+	static int refxxctionStage(int bounce)
+	{
+		if(bounce < 1) bounce = 1;
+		if(bounce > STAGE_TIMER_LEVELS) bounce = STAGE_TIMER_LEVELS;
+		return REFXXCTION_TRAVERSAL + bounce - 1;
+	}
+
+	/// primary, shadow and reflection/refraction traversal
+	static bool isTraversal(int stage)
+	{
+		return stage == PRIMARY_TRAVERSAL || stage == SHADOW_TRAVERSAL || (stage >= REFXXCTION_TRAVERSAL && stage < CONVERT);
+	}
+
+	static const char* getStageName(int stage)
+	{
+		static const char* names[] = { "other", "clear", "camera rays", "primary traversal", "shading", "shadow traversal", "sorting" };
+		static char levelNames[STAGE_TIMER_LEVELS][32];
+
+		if(stage < REFXXCTION_TRAVERSAL) return names[stage];
+		if(stage == CONVERT) return "convert";
+		if(stage == DISPLAY) return "display";
+
+		char* name = levelNames[stage - REFXXCTION_TRAVERSAL];
+		if(!name[0]) sprintf(name, "bounce %d traversal", stage - REFXXCTION_TRAVERSAL + 1);
+		return name;
+	}
+
+private:
+	int current;
+	double last;
+	const PerfCounters* counters;
+	uint64_t lastEvents[PerfCounters::EVENT_COUNT];
+
+	void switchTo(int stage)
+	{
+		double time = TimeMeasurement::now();
+		seconds[current] += time - last;
+		last = time;
+
+		if(counters)
+		{
+			uint64_t counts[PerfCounters::EVENT_COUNT];
+			counters->read(counts);
+			for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+			{
+				events[current][e] += (double)(counts[e] - lastEvents[e]);
+				lastEvents[e] = counts[e];
+			}
+		}
+
+		current = stage;
+	}
+};
+
+/// enters a stage for the lifetime of the scope. does nothing if the timer is NULL (measurements disabled).
+class StageScope
+{
+public:
+	StageScope(StageTimer* timer, int stage) : timer(timer), enclosing(StageTimer::OTHER)
+	{
+		if(timer) enclosing = timer->enter(stage);
+	}
+
+	~StageScope()
+	{
+		if(timer) timer->leave(enclosing);
+	}
+
+private:
+	StageTimer* timer;
+	int enclosing;
+};
+
+#endif
@@ -1,5 +0,0 @@
-
-// Set to 1 to use very high precision for node surface ratio computation. You can set the precision in bigfloat.h
-#if 1
-	#define BIGFLOAT_SURFACE_COMPUTATION
-#endif
\ No newline at end of file
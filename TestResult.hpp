@@ -12,6 +12,8 @@
 #include <iostream>
 #include <fstream>
 
+#include "StageTimer.hpp"
+
 
 struct TestResult
 {
@@ -29,6 +31,16 @@ struct TestResult
 	unsigned long rayNodeIntersections;
 	unsigned long rayTriangleIntersections;
 
+	// exclusive time per render stage summed over all threads. see StageTimer.
+	double lastStageTimes[StageTimer::STAGE_COUNT];
+	double stageTimeSums[StageTimer::STAGE_COUNT];
+	unsigned long stageFrames;
+
+	// hardware events per render stage summed over all threads. see PerfCounters.
+	double stageEventSums[StageTimer::STAGE_COUNT][PerfCounters::EVENT_COUNT];
+	bool eventAvailable[PerfCounters::EVENT_COUNT];
+	unsigned long eventFrames;
+
 	TestResult()
 	{
 		clear();
@@ -48,6 +60,96 @@ struct TestResult
 		maxRayTraceTime = -1.0;
 		rayNodeIntersections = 0;
 		rayTriangleIntersections = 0;
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			lastStageTimes[i] = 0.0;
+			stageTimeSums[i] = 0.0;
+			for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) stageEventSums[i][e] = 0.0;
+		}
+		stageFrames = 0;
+		for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) eventAvailable[e] = false;
+		eventFrames = 0;
+	}
+
+	void addStageTimes(const double* times)
+	{
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			lastStageTimes[i] = times[i];
+			stageTimeSums[i] += times[i];
+		}
+		++stageFrames;
+	}
+
+	double getAverageStageTime(int stage) const
+	{
+		return stageFrames ? stageTimeSums[stage] / stageFrames : 0.0;
+	}
+
+	void addStageEvents(const double events[][PerfCounters::EVENT_COUNT], const PerfCounters& counters)
+	{
+		for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+		{
+			eventAvailable[e] = counters.isAvailable(e);
+			for (int i = 0; i < StageTimer::STAGE_COUNT; ++i) stageEventSums[i][e] += events[i][e];
+		}
+		++eventFrames;
+	}
+
+	double getAverageStageEvents(int stage, int event) const
+	{
+		return eventFrames ? stageEventSums[stage][event] / eventFrames : 0.0;
+	}
+
+	/// events of the primary, shadow and reflection/refraction traversal per frame
+	double getAverageTraversalEvents(int event) const
+	{
+		double sum = 0.0;
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			if(StageTimer::isTraversal(i)) sum += getAverageStageEvents(i, event);
+		}
+		return sum;
+	}
+
+	void printEvents(std::ostream& stream, const char* name, const double* events)
+	{
+		stream << "  " << name << ":";
+		for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+		{
+			stream << (e ? ", " : " ") << PerfCounters::getEventName(e) << " ";
+			if(eventAvailable[e]) stream << events[e];
+			else stream << "n/a";
+		}
+		if(eventAvailable[PerfCounters::CYCLES] && eventAvailable[PerfCounters::INSTRUCTIONS] && events[PerfCounters::CYCLES] > 0.0)
+		{
+			stream << ", instructions per cycle " << events[PerfCounters::INSTRUCTIONS] / events[PerfCounters::CYCLES];
+		}
+		stream << "\n";
+	}
+
+	void printStageEvents(std::ostream& stream)
+	{
+		stream << "average hardware events per frame (summed over threads):\n";
+		double events[PerfCounters::EVENT_COUNT];
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			if(getAverageStageTime(i) <= 0.0) continue;
+			for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) events[e] = getAverageStageEvents(i, e);
+			printEvents(stream, StageTimer::getStageName(i), events);
+		}
+		for (int e = 0; e < PerfCounters::EVENT_COUNT; ++e) events[e] = getAverageTraversalEvents(e);
+		printEvents(stream, "all traversal", events);
+	}
+
+	void printStageTimes(std::ostream& stream, bool average)
+	{
+		stream << (average ? "average" : "last") << " stage times (summed over threads):\n";
+		for (int i = 0; i < StageTimer::STAGE_COUNT; ++i)
+		{
+			double time = average ? getAverageStageTime(i) : lastStageTimes[i];
+			if(time > 0.0) stream << "  " << StageTimer::getStageName(i) << ": " << time << "\n";
+		}
 	}
 
 	void print(int resolutionX, int resolutionY)
@@ -99,7 +201,10 @@ struct TestResult
 				<< "last raytrace time: " << lastRayTraceTime << "\n"
 				<< "minimum raytrace time: " << minRayTraceTime << "\n"
 				<< "average raytrace time: " << avgRayTraceTime << "\n"
-				<< "maximum raytrace time: " << maxRayTraceTime << "\n\n";
+				<< "maximum raytrace time: " << maxRayTraceTime << "\n";
+		if(stageFrames) printStageTimes(stream, true);
+		if(eventFrames) printStageEvents(stream);
+		stream << "\n";
 	}
 
 	void printFirstFrame()
@@ -155,6 +260,7 @@ struct TestResult
 			<< "minimum raytrace time: " << minRayTraceTime << "\n"
 			<< "average raytrace time: " << avgRayTraceTime << "\n"
 			<< "maximum raytrace time: " << maxRayTraceTime << "\n";
+		if(stageFrames) printStageTimes(std::cout, false);
 	}
 };
 
@@ -12,8 +12,7 @@
 #include <fstream>
 
 #include "SimpleScene.hpp"
-
-#include "TestConfig.hpp"
+#include "HierarchyStatistics.hpp"
 
 struct TestSetup
 {
@@ -23,16 +22,17 @@ struct TestSetup
 
 	bool orderedTraversal;
 	bool iterativeTraversal;
+	bool shortStackTraversal;
 	int threads;
 
+	/// analysis of the acceleration structure after construction. see Scene::analyze
+	bool hierarchyAnalyzed;
+	HierarchyStatistics hierarchy;
+
 	TestSetup()
 	{
 		clear();
-		#ifdef MULTITHREADING
-			threads = THREAD_COUNT;
-		#else
-			threads = 1;
-		#endif
+		threads = 1;	// set by the renderer
 		#ifdef TRAVERSE_ORDERED
 			orderedTraversal = true;
 		#else
@@ -43,11 +43,18 @@ struct TestSetup
 		#else
 			iterativeTraversal = false;
 		#endif
+		#if defined(TRAVERSE_ITERATIVE) && defined(TRAVERSE_SHORTSTACK)
+			shortStackTraversal = true;
+		#else
+			shortStackTraversal = false;
+		#endif
 	}
 
 	void clear()
 	{
 		constructionTime = -1.0;
+		hierarchyAnalyzed = false;
+		hierarchy.clear();
 	}
 
 	void print(bool testMode, SceneConstructionDetails& construction, unsigned long computedMemoryUsage, const char* modelFile, SCENE_TYPE method, const char* methodStr, unsigned long framesPerTest, Scene* scene, int width, int height)
@@ -82,19 +89,13 @@ struct TestSetup
 			<< "inner node count: " << construction.innerNodes << "\n"
 			<< "leaf node count: " << construction.leafNodes << "\n"
 			<< "computed memory usage of nodes: " << computedMemoryUsage << "\n";
-		if(method == SSH)
+		if(hierarchyAnalyzed)
 		{
-			stream << "average node surface ratio approx/real: "
-				#ifdef BIGFLOAT_SURFACE_COMPUTATION
-					<< construction.bshSurfaceRatio.getdouble()
-				#else
-					<< construction.bshSurfaceRatio
-				#endif
-				<< "\n";
+			hierarchy.print(stream);
 		}
-		if(method == SSH || method == BVH)
+		if(method == SSH || method == BVH || method == DSH || method == HYBRID)
 		{
-			stream << "traversal algorithm: " << (iterativeTraversal?"iterative":"recursive") << (orderedTraversal?", ordered":"") << "\n";
+			stream << "traversal algorithm: " << (iterativeTraversal?"iterative":"recursive") << (shortStackTraversal?", short stack":"") << (orderedTraversal?", ordered":"") << "\n";
 		}
 	}
 };
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <assert.h>
+
+#include "TileScheduler.hpp"
+
+/// inserts a zero bit between each of the lowest 16 bits
+static unsigned int spreadBits(unsigned int v)
+{
+	v &= 0x0000ffff;
+	v = (v | (v << 8)) & 0x00ff00ff;
+	v = (v | (v << 4)) & 0x0f0f0f0f;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+// tile index with morton code for sorting
+struct MortonTile
+{
+	unsigned int code;
+	TileScheduler::Tile tile;
+
+	bool operator<(const MortonTile& other) const { return code < other.code; }
+};
+
+TileScheduler::TileScheduler() : width(0), height(0), tileSize(0), deques(0), threadCount(0)
+{
+}
+
+TileScheduler::~TileScheduler()
+{
+	createDeques(0);
+}
+
+void TileScheduler::createTiles(int width, int height, int tileSize)
+{
+	this->width = width;
+	this->height = height;
+	this->tileSize = tileSize;
+
+	std::vector<MortonTile> mortonTiles;
+	for (int ty = 0; ty * tileSize < height; ++ty)
+	{
+		for (int tx = 0; tx * tileSize < width; ++tx)
+		{
+			MortonTile t;
+			t.code = spreadBits(tx) | (spreadBits(ty) << 1);
+			t.tile.x0 = tx * tileSize;
+			t.tile.y0 = ty * tileSize;
+			t.tile.x1 = std::min(width, t.tile.x0 + tileSize);
+			t.tile.y1 = std::min(height, t.tile.y0 + tileSize);
+			mortonTiles.push_back(t);
+		}
+	}
+
+	std::sort(mortonTiles.begin(), mortonTiles.end());
+
+	tiles.resize(mortonTiles.size());
+	for (size_t i = 0; i < mortonTiles.size(); ++i)
+	{
+		tiles[i] = mortonTiles[i].tile;
+	}
+}
+
+void TileScheduler::createDeques(int threadCount)
+{
+	for (int i = 0; i < this->threadCount; ++i)
+	{
+		omp_destroy_lock(&deques[i].lock);
+	}
+	delete[] deques;
+	deques = 0;
+
+	this->threadCount = threadCount;
+	if(threadCount > 0)
+	{
+		deques = new Deque[threadCount];
+		for (int i = 0; i < threadCount; ++i)
+		{
+			omp_init_lock(&deques[i].lock);
+			deques[i].node = 0;
+		}
+	}
+}
+
+void TileScheduler::setup(int width, int height, int tileSize, int threadCount)
+{
+	assert(tileSize > 0 && tileSize % 2 == 0);
+	assert(threadCount > 0);
+
+	if(width != this->width || height != this->height || tileSize != this->tileSize)
+	{
+		createTiles(width, height, tileSize);
+	}
+
+	if(threadCount != this->threadCount)
+	{
+		createDeques(threadCount);
+	}
+
+	// deal contiguous ranges of the morton order
+	int count = (int)tiles.size();
+	for (int i = 0; i < threadCount; ++i)
+	{
+		deques[i].front = (int)((unsigned long)count * i / threadCount);
+		deques[i].back = (int)((unsigned long)count * (i+1) / threadCount);
+	}
+}
+
+bool TileScheduler::nextTile(int thread, Tile& tile)
+{
+	assert(thread >= 0 && thread < threadCount);
+
+	// own tiles first
+	Deque& own = deques[thread];
+	omp_set_lock(&own.lock);
+	if(own.front < own.back)
+	{
+		tile = tiles[own.front++];
+		omp_unset_lock(&own.lock);
+		return true;
+	}
+	omp_unset_lock(&own.lock);
+
+	// only the owner writes its node, under its lock
+	int ownNode = own.node;
+
+	// steal from the back of the other deques. the back is far away from the tiles the owner works on.
+	// the first pass robs threads on the same NUMA node, the second pass all others.
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int i = 1; i < threadCount; ++i)
+		{
+			Deque& victim = deques[(thread + i) % threadCount];
+
+			omp_set_lock(&victim.lock);
+			if((victim.node == ownNode) == (pass == 0) && victim.front < victim.back)
+			{
+				tile = tiles[--victim.back];
+				omp_unset_lock(&victim.lock);
+				return true;
+			}
+			omp_unset_lock(&victim.lock);
+		}
+	}
+
+	return false;
+}
+
+void TileScheduler::setThreadNode(int thread, int node)
+{
+	assert(thread >= 0 && thread < threadCount);
+
+	// other threads read the node while they look for a victim
+	omp_set_lock(&deques[thread].lock);
+	deques[thread].node = node;
+	omp_unset_lock(&deques[thread].lock);
+}
@@ -0,0 +1,66 @@
+#ifndef TILESCHEDULER_HPP
+#define TILESCHEDULER_HPP
+
+#include <vector>
+
+#include "simd/simd.h"
+#include "MultiThreading.hpp"
+
+/*
+	distributes the image tiles among the render threads.
+	the tiles are issued in morton order and each thread gets a contiguous range of that order, so consecutive tiles of a thread are
+	neighbours and share the cached nodes and triangles. each thread works off its own deque from the front. threads which run out of
+	tiles steal from the back of other deques, so threads which got the expensive tiles do not stall the frame. threads on the same
+	NUMA node are robbed first.
+*/
+class TileScheduler
+{
+public:
+	struct Tile
+	{
+		int x0, y0;	// first pixel
+		int x1, y1;	// behind last pixel
+	};
+
+	TileScheduler();
+	~TileScheduler();
+
+	/// splits the image into tiles and deals them to the thread deques. must be called before each frame.
+	/// tileSize has to be a multiple of 2 because the rays are traced in 2x2 packets.
+	void setup(int width, int height, int tileSize, int threadCount);
+
+	/// gets the next tile of the thread or steals one from another thread. returns false if no tile is left.
+	bool nextTile(int thread, Tile& tile);
+
+	/// tells the NUMA node the thread runs on. threads steal from threads on their own node first.
+	void setThreadNode(int thread, int node);
+
+	int getTileCount() const { return (int)tiles.size(); }
+
+private:
+	// tile range [front, back) of one thread
+	struct DequeState
+	{
+		omp_lock_t lock;
+		int front;
+		int back;
+		int node;	// NUMA node of the owner. guarded by the lock.
+	};
+	// the deque array is aligned to cache lines and each deque fills whole lines, so threads do not share cache lines
+	struct Deque : public memAligned<CACHE_LINE_SIZE>, public DequeState
+	{
+		char padding[CACHE_LINE_SIZE - sizeof(DequeState) % CACHE_LINE_SIZE];
+	};
+
+	std::vector<Tile> tiles;	// morton order
+	int width;
+	int height;
+	int tileSize;
+	Deque* deques;
+	int threadCount;
+
+	void createTiles(int width, int height, int tileSize);
+	void createDeques(int threadCount);
+};
+
+#endif
@@ -14,7 +14,7 @@
 #ifdef WINDOWS
 #include <windows.h>
 #else
-#include <sys/time.h>
+#include <time.h>
 #endif
 
 using namespace std;
@@ -22,12 +22,7 @@ using namespace std;
 class TimeMeasurement
 {
 private:
-	#ifdef WINDOWS
-		LARGE_INTEGER perfCounterFrequency;
-		LARGE_INTEGER start;
-	#else
-		timeval start;
-	#endif
+	double start;
 	double accumulator;
 	double timeSum;
 	int frames;
@@ -40,11 +35,28 @@ public:
 		accumulator = 0;
 		timeSum = 0;
 		frames = 0;
+		start = now();
+	}
+
+	/// seconds of a monotonic high-resolution clock. only differences are meaningful.
+	static double now()
+	{
 		#ifdef WINDOWS
-			QueryPerformanceFrequency(&perfCounterFrequency);
-			QueryPerformanceCounter(&start);
+			static LARGE_INTEGER perfCounterFrequency;
+			static bool initialized = false;
+			if(!initialized)
+			{
+				QueryPerformanceFrequency(&perfCounterFrequency);
+				initialized = true;
+			}
+			LARGE_INTEGER current;
+			QueryPerformanceCounter(&current);
+			return (double)current.QuadPart / (double)perfCounterFrequency.QuadPart;
 		#else
-			gettimeofday(&start, NULL);
+			// unlike gettimeofday the monotonic clock does not jump when the system time is adjusted
+			timespec current;
+			clock_gettime(CLOCK_MONOTONIC, &current);
+			return double(current.tv_sec) + double(current.tv_nsec)/1000000000.0;
 		#endif
 	}
 
@@ -58,11 +70,7 @@ public:
 	{
 		pausing = false;
 		accumulator = 0;
-		#ifdef WINDOWS
-			QueryPerformanceCounter(&start);
-		#else
-			gettimeofday(&start, NULL);
-		#endif
+		start = now();
 	}
 
 	void pause()
@@ -74,31 +82,15 @@ public:
 	void resume()
 	{
 		// set new start. time between previous start and pause has been saved in accumulator and will be added to upcoming getCurrentTime calls
-		#ifdef WINDOWS
-			QueryPerformanceCounter(&start);
-		#else
-			gettimeofday(&start, NULL);
-		#endif
+		start = now();
 		pausing = false;
 	}
 
 	double getCurrentTime()
 	{
-		#ifdef WINDOWS
-			LARGE_INTEGER current;
-			QueryPerformanceCounter(&current);
-		#else
-			timeval current;
-			gettimeofday(&current, NULL);
-		#endif
-
 		if(pausing) return accumulator;
 		
-		#ifdef WINDOWS
-			return accumulator + (double)(current.QuadPart - start.QuadPart) / (double)perfCounterFrequency.QuadPart;
-		#else
-			return accumulator + double(current.tv_sec - start.tv_sec) + double(current.tv_usec - start.tv_usec)/1000000.0;
-		#endif
+		return accumulator + now() - start;
 	}
 
 	void printCurrentTime(const char* text)
@@ -0,0 +1,65 @@
+#include <fstream>
+
+#include "TraceRecorder.hpp"
+
+TraceRecorder::~TraceRecorder()
+{
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		delete buffers[i];
+	}
+}
+
+void TraceRecorder::enable(const char* fileName)
+{
+	this->fileName = fileName;
+	origin = TimeMeasurement::now();
+	reserveThreads(1);
+}
+
+void TraceRecorder::reserveThreads(int threadCount)
+{
+	if(!isEnabled()) return;
+	while((int)buffers.size() < threadCount)
+	{
+		buffers.push_back(new TraceBuffer());
+	}
+}
+
+bool TraceRecorder::write() const
+{
+	std::ofstream file(fileName.c_str());
+	if(file.fail()) return false;
+
+	// timestamps in microseconds since enable
+	file.setf(std::ios::fixed);
+	file.precision(3);
+
+	unsigned long dropped = 0;
+	bool first = true;
+	file << "{\"traceEvents\":[\n";
+	for (size_t t = 0; t < buffers.size(); ++t)
+	{
+		const TraceBuffer& buffer = *buffers[t];
+		dropped += buffer.getDropped();
+
+		file << (first ? "" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+			<< ",\"args\":{\"name\":\"thread " << t << (t == 0 ? " (master)" : "") << "\"}}";
+		first = false;
+
+		for (unsigned long i = 0; i < buffer.size(); ++i)
+		{
+			const TraceEvent& event = buffer[i];
+			file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t
+				<< ",\"ts\":" << (event.begin - origin) * 1e6
+				<< ",\"dur\":" << (event.end - event.begin) * 1e6;
+			if(event.argName) file << ",\"args\":{\"" << event.argName << "\":" << event.arg << "}";
+			file << "}";
+		}
+	}
+	file << "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"droppedSpans\":" << dropped << "}}\n";
+
+	file.close();
+	return !file.fail();
+}
@@ -0,0 +1,117 @@
+#ifndef TRACERECORDER_HPP
+#define TRACERECORDER_HPP
+
+#include <vector>
+#include <string>
+
+#include "simd/simd.h"
+#include "MultiThreading.hpp"
+#include "TimeMeasurement.hpp"
+
+// spans kept per thread. older spans are overwritten.
+#define TRACE_BUFFER_EVENTS 65536
+
+/// a span of one thread. name and argName have to be string literals, so recording copies no strings.
+struct TraceEvent
+{
+	const char* name;
+	const char* argName;	// NULL if the span has no argument
+	int arg;
+	double begin;	// seconds of TimeMeasurement::now()
+	double end;
+};
+
+/// ring buffer of the spans of one thread. aligned to cache lines, so threads do not share cache lines.
+class TraceBuffer : public memAligned<CACHE_LINE_SIZE>
+{
+public:
+	TraceBuffer() : events(TRACE_BUFFER_EVENTS), written(0) {}
+
+	inline void add(const char* name, double begin, double end, const char* argName = NULL, int arg = 0)
+	{
+		TraceEvent& event = events[written % TRACE_BUFFER_EVENTS];
+		event.name = name;
+		event.argName = argName;
+		event.arg = arg;
+		event.begin = begin;
+		event.end = end;
+		++written;
+	}
+
+	unsigned long size() const { return written < TRACE_BUFFER_EVENTS ? written : TRACE_BUFFER_EVENTS; }
+	unsigned long getDropped() const { return written - size(); }
+
+	/// i-th span from the oldest one kept
+	const TraceEvent& operator[](unsigned long i) const
+	{
+		return events[(written - size() + i) % TRACE_BUFFER_EVENTS];
+	}
+
+private:
+	std::vector<TraceEvent> events;
+	unsigned long written;
+	char padding[CACHE_LINE_SIZE];
+};
+
+/*
+	timeline of the spans of all threads (loading, construction, frames, tiles, secondary ray levels, display).
+	each thread records into its own ring buffer, so recording needs no synchronization and costs two clock reads per span.
+	the spans are written in the Chrome trace event format, which chrome://tracing and ui.perfetto.dev open.
+*/
+class TraceRecorder
+{
+public:
+	TraceRecorder() : origin(0.0) {}
+	~TraceRecorder();
+
+	/// starts recording. the timeline starts now.
+	void enable(const char* fileName);
+	bool isEnabled() const { return !fileName.empty(); }
+	const char* getFileName() const { return fileName.c_str(); }
+
+	/// allocates the buffers of the threads 0 to threadCount-1. must not be called while threads record.
+	void reserveThreads(int threadCount);
+
+	/// buffer of a thread. NULL if recording is disabled.
+	inline TraceBuffer* getBuffer(int thread)
+	{
+		return thread < (int)buffers.size() ? buffers[thread] : (TraceBuffer*)NULL;
+	}
+
+	/// writes the spans of all threads as Chrome trace JSON. returns false if the file could not be written.
+	bool write() const;
+
+private:
+	std::string fileName;
+	std::vector<TraceBuffer*> buffers;
+	double origin;
+
+	// not copyable
+	TraceRecorder(const TraceRecorder&);
+	TraceRecorder& operator=(const TraceRecorder&);
+};
+
+/// records a span for the lifetime of the scope. does nothing if the buffer is NULL (recording disabled).
+class TraceScope
+{
+public:
+	TraceScope(TraceBuffer* buffer, const char* name, const char* argName = NULL, int arg = 0)
+		: buffer(buffer), name(name), argName(argName), arg(arg), begin(0.0)
+	{
+		if(buffer) begin = TimeMeasurement::now();
+	}
+
+	~TraceScope()
+	{
+		if(buffer) buffer->add(name, begin, TimeMeasurement::now(), argName, arg);
+	}
+
+private:
+	TraceBuffer* buffer;
+	const char* name;
+	const char* argName;
+	int arg;
+	double begin;
+};
+
+#endif
@@ -5,10 +5,11 @@
 using namespace std;
 
 unsigned Triangle::intersectionTestsPerformed;
+bool Triangle::countIntersectionTests = false;
 
 void Triangle::intersect(PackedRay &ray)
 {
-	Triangle::intersectionTestsPerformed++;
+	if(Triangle::countIntersectionTests) Triangle::intersectionTestsPerformed++;
 
 	//if((dot(ray.dir, qvec(vec(na))) < qfloat(0.0f)).allTrue()) return;
 
@@ -161,6 +161,8 @@ class Triangle
 	Material* material;
 	
 	static unsigned intersectionTestsPerformed;
+	// the counter is not synchronized, so it is only counted while one thread renders
+	static bool countIntersectionTests;
 	
   private:
 	vec a, edge_ab, edge_ac, na, nb, nc, ta, tb, tc;
@@ -2,19 +2,19 @@
 #include <iostream>
 
 #include "XHierarchy.hpp"
+#include "XHierarchySpatialMedianCut.hpp"
 #include "Triangle.hpp"
 
-void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qmask reverse[3], const SSHNode* node, qfloat& t_near, qfloat& t_far)
+// active ray segment of a slab node (SSHNode, DSHNode, HybridNode)
+static inline void clipBySlab(const PackedRay& ray, const qmask reverse[3], unsigned long axis, bool isNear, float plane, qfloat& t_near, qfloat& t_far)
 {
-	unsigned long axis = node->getSlabAxis();
-
-	qfloat t = (qfloat(node->plane) - ray.origin[axis]) * ray.dirrcp[axis];
+	qfloat t = (qfloat(plane) - ray.origin[axis]) * ray.dirrcp[axis];
 
 	// update active ray segment
 
 	#if 0
 	// funktioniert, falls alle Strahlen die gleichen Richtungsvorzeichen haben
-	if(node->isNear()){
+	if(isNear){
 		if(reverse[axis].mask()){
 			t_far.condAssign(t<t_far, t, t_far);
 		}
@@ -35,7 +35,7 @@ void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qma
 	#if 0
 	// funktioniert, falls alle Strahlen die gleichen Richtungsvorzeichen haben
 	if(reverse[axis].mask()){
-		if(node->isNear()){
+		if(isNear){
 			t_far.condAssign(t<t_far, t, t_far);
 		}
 		else{
@@ -43,7 +43,7 @@ void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qma
 		}
 	}
 	else{
-		if(node->isNear()){
+		if(isNear){
 			t_near.condAssign(t>t_near, t, t_near);
 		}
 		else{
@@ -54,7 +54,7 @@ void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qma
 
 	#if 0
 	// funktioniert, falls alle Strahlen die gleichen Richtungsvorzeichen haben
-	if(reverse[axis].mask() ^ (SSH_UNPACK_FLAGS(node->flags) & SSHNode::NEAR_FLAG)){
+	if(reverse[axis].mask() ^ isNear){
 		// update t_near if necessary, keep t_far
 		t_near.condAssign(t > t_near, t, t_near);
 	} else {
@@ -64,7 +64,7 @@ void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qma
 	#endif
 
 	// funktioniert auch mit Strahlen, die unterschiedliche Richtungsvorzeichen haben
-	if (node->isNear())
+	if (isNear)
 	{
 		// near plane
 		t_near.condAssign((reverse[axis] | (t<=t_near)), t_near, t);	// increase t_near
@@ -78,14 +78,15 @@ void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qma
 	}
 }
 
-void BoundingVolumeHierarchy::updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const BVHNode *node, qfloat& t_near, qfloat& t_far)
+// active ray segment of a box node (BVHNode, HybridNode)
+static inline void clipByBox(const PackedRay &ray, const vec& min, const vec& max, qfloat& t_near, qfloat& t_far)
 {
 	qfloat txnear, txfar, tynear, tyfar, tznear, tzfar;
 	
 	// x axis slab
 	qmask m = ray.dirrcp.x >= 0.0f;
-	qfloat minval = (node->min.x - ray.origin.x) * ray.dirrcp.x;
-	qfloat maxval = (node->max.x - ray.origin.x) * ray.dirrcp.x;
+	qfloat minval = (min.x - ray.origin.x) * ray.dirrcp.x;
+	qfloat maxval = (max.x - ray.origin.x) * ray.dirrcp.x;
 	txnear.condAssign(m, minval, maxval);
 	txfar.condAssign(m, maxval, minval);
 	
@@ -94,8 +95,8 @@ void BoundingVolumeHierarchy::updateActiveRaySegment(const PackedRay &ray, const
 	
 	// y axis slab
 	m = ray.dirrcp.y >= 0.0f;
-	minval = (node->min.y - ray.origin.y) * ray.dirrcp.y;
-	maxval = (node->max.y - ray.origin.y) * ray.dirrcp.y;
+	minval = (min.y - ray.origin.y) * ray.dirrcp.y;
+	maxval = (max.y - ray.origin.y) * ray.dirrcp.y;
 	tynear.condAssign(m, minval, maxval);
 	tyfar.condAssign(m, maxval, minval);
 	
@@ -104,11 +105,61 @@ void BoundingVolumeHierarchy::updateActiveRaySegment(const PackedRay &ray, const
 	
 	// z axis slab
 	m = ray.dirrcp.z >= 0.0f;
-	minval = (node->min.z - ray.origin.z) * ray.dirrcp.z;
-	maxval = (node->max.z - ray.origin.z) * ray.dirrcp.z;
+	minval = (min.z - ray.origin.z) * ray.dirrcp.z;
+	maxval = (max.z - ray.origin.z) * ray.dirrcp.z;
 	tznear.condAssign(m, minval, maxval);
 	tzfar.condAssign(m, maxval, minval);
 	
 	t_near.condAssign(tznear > t_near, tznear, t_near);
 	t_far.condAssign(tzfar < t_far, tzfar, t_far);
-}
\ No newline at end of file
+}
+void SingleSlabHierarchy::updateActiveRaySegment(const PackedRay& ray, const qmask reverse[3], const SSHNode* node, qfloat& t_near, qfloat& t_far)
+{
+	clipBySlab(ray, reverse, node->getSlabAxis(), node->isNear(), node->plane, t_near, t_far);
+}
+
+void BoundingVolumeHierarchy::updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const BVHNode *node, qfloat& t_near, qfloat& t_far)
+{
+	clipByBox(ray, node->min, node->max, t_near, t_far);
+}
+
+void DualSlabHierarchy::updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const DSHNode *node, qfloat& t_near, qfloat& t_far)
+{
+	clipBySlab(ray, reverse, node->getSlabAxis(), node->isNear(), node->plane, t_near, t_far);
+	clipBySlab(ray, reverse, node->getSecondSlabAxis(), node->isSecondNear(), node->secondPlane, t_near, t_far);
+}
+
+HybridHierarchy::HybridHierarchy(HybridHierarchySpatialMedianCut* conStrat) : XHierarchy<HybridNode>(conStrat), builder(conStrat)
+{
+}
+
+SceneConstructionDetails HybridHierarchy::construct(std::vector<Triangle>* geometries)
+{
+	SceneConstructionDetails result = XHierarchy<HybridNode>::construct(geometries);
+	builder->takeBoxes(boxes);
+	return result;
+}
+
+bool HybridHierarchy::analyze(HierarchyStatistics& out)
+{
+	if(!triangles || triangles->empty()) return false;
+
+	HybridNode* nodes;
+	Triangle* tris;
+	getArrays(nodes, tris);
+	HierarchyAnalyzer<HybridNode>::analyze(nodes, nodeCount, tris, bounds, HybridTraversalBox(boxes.empty() ? NULL : &boxes[0]), out);
+	return true;
+}
+
+void HybridHierarchy::updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const HybridNode *node, qfloat& t_near, qfloat& t_far)
+{
+	if(node->isBox())
+	{
+		const HybridBox& box = boxes[node->boxIndex];
+		clipByBox(ray, box.min, box.max, t_near, t_far);
+	}
+	else
+	{
+		clipBySlab(ray, reverse, node->getSlabAxis(), node->isNear(), node->plane, t_near, t_far);
+	}
+}
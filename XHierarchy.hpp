@@ -4,10 +4,15 @@
 #include <string.h>
 
 #include "MultiThreading.hpp"
+#include "NumaPlacement.hpp"
+#include "HierarchyAnalyzer.hpp"
+#include "NodeAccessTrace.hpp"
 #include "XHierarchyConfig.hpp"
 
 #include "SSHNode.hpp"
 #include "BVHNode.hpp"
+#include "DSHNode.hpp"
+#include "HybridNode.hpp"
 
 #include "Triangle.hpp"
 #include "Scene.hpp"
@@ -36,11 +41,13 @@ template<typename Node>
 class XHierarchy : public Scene
 {
 public:
-	XHierarchy(XHierarchyConstructionStrategy<Node> *conStrat) : conStrat(conStrat), root(NULL) {}
+	XHierarchy(XHierarchyConstructionStrategy<Node> *conStrat) : replicaTriangleCount(0), accessTrace(NULL), conStrat(conStrat), root(NULL), height(0), triangles(NULL) {}
 	~XHierarchy()
 	{
 		delete conStrat;
 		delete[] root;
+		releaseArrays();
+		deleteStacks();
 	}
 
 	virtual unsigned long getComputedMemoryUsage() const
@@ -50,38 +57,69 @@ public:
 
 	virtual const AABBox& getBounds() const { return bounds; }
 
-	virtual IntersectDetails intersect(PackedRay& ray)
+	virtual bool analyze(HierarchyStatistics& out)
 	{
-		IntersectDetails result;
-		result.rayNodeIntersections = 0;
-
-		qfloat tnear = 0.0f;
-		qfloat tfar = ray.t;
-
-		bounds.clip(ray, tnear, tfar);
+		if(!triangles || triangles->empty()) return false;
 
-		if ((tnear > tfar).allTrue())
-		{
-			return result;	// all rays miss bounds
-		}
-
-		qmask reverse[3];
-		reverse[0] = ray.dirrcp.x < 0.0f;
-		reverse[1] = ray.dirrcp.y < 0.0f;
-		reverse[2] = ray.dirrcp.z < 0.0f;
+		Node* nodes;
+		Triangle* tris;
+		getArrays(nodes, tris);
+		HierarchyAnalyzer<Node>::analyze(nodes, nodeCount, tris, bounds, out);
+		return true;
+	}
 
+	/// only the iterative traversal with the full stack logs the accesses. it is used for all packets while tracing.
+	/// the layout of the trace is the one of the last construct.
+	virtual bool setAccessTrace(NodeAccessTrace* trace)
+	{
 		#ifdef TRAVERSE_ITERATIVE
-			traverse_iterative(ray, root, tnear, tfar, reverse, result);
+			if(trace)
+			{
+				if(!triangles || triangles->empty() || nodeCount > NodeAccessTrace::MAX_INDEX) return false;
+				trace->setLayout(sizeof(Node), Node::memSize, nodeCount, sizeof(Triangle), triangles->size());
+				if(remainingNodes.empty()) createStacks();
+			}
+			accessTrace = trace;
+			return true;
 		#else
-			traverse_recursive(ray, root, root, tnear, tfar, reverse, result);
+			return false;
 		#endif
+	}
 
+	virtual IntersectDetails intersect(PackedRay& ray)
+	{
+		IntersectDetails result;
+		intersectPacket(ray, result);
 		return result;
 	}
 
+	virtual void intersectPackets(PackedRay** rays, unsigned int count, IntersectDetails& out)
+	{
+		#if defined(TRAVERSE_ITERATIVE) && INTERLEAVED_PACKETS > 1
+			if(trailFitsTreeHeight() && !accessTrace)
+			{
+				for (unsigned int i = 0; i < count; i += INTERLEAVED_PACKETS)
+				{
+					traverse_interleaved(&rays[i], count-i < INTERLEAVED_PACKETS ? count-i : INTERLEAVED_PACKETS, out.lanes ? out.lanes + i : NULL, out);
+				}
+				return;
+			}
+		#endif
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			// the lane counters of a single packet
+			IntersectDetails details;
+			details.lanes = out.lanes ? out.lanes + i : NULL;
+			intersectPacket(*rays[i], details);
+			out.rayNodeIntersections += details.rayNodeIntersections;
+		}
+	}
+
 	virtual SceneConstructionDetails construct(std::vector<Triangle>* geometries)
 	{
 		assert(geometries);
+		releaseArrays();	// sized by the previous node count
 		this->triangles = geometries;
 
 		// compute bounds
@@ -101,16 +139,17 @@ public:
 		result.height = 0;
 
 		conStrat->construct(*triangles, bounds, root, result);
+		height = result.height;
+
+		placeArrays();
 
 		#ifdef TRAVERSE_ITERATIVE
-			#ifdef MULTITHREADING
-				for(int i = 0; i < THREAD_COUNT; ++i)
-				{
-					remainingNodes[i].reserve(result.height);
-				}
-			#else
-				remainingNodes.reserve(result.height);
+			#ifdef TRAVERSE_SHORTSTACK
+				// the full stack is needed only if the tree is too high for the restart trail or the accesses are traced
+				if(trailFitsTreeHeight() && !accessTrace) return result;
+				if(!trailFitsTreeHeight()) std::cout << "tree height " << height << " exceeds restart trail. using full stack traversal." << std::endl;
 			#endif
+			createStacks();
 		#endif
 
 		return result;
@@ -132,6 +171,11 @@ private:
 			currentFree = 0;
 		}
 
+		~Stack()
+		{
+			delete[] data;
+		}
+
 		inline void reserve(unsigned long count)
 		{
 			assert(size <= count);
@@ -175,24 +219,379 @@ protected:
 		qfloat t_near;
 		qfloat t_far;
 	};
-	#ifdef MULTITHREADING
-		Stack<StackData> remainingNodes[THREAD_COUNT];
-	#else
-		Stack<StackData> remainingNodes;
-	#endif
+	// stack of one thread. each stack is allocated separately and aligned to cache lines, so threads do not share cache lines.
+	struct ThreadStack : public memAligned<CACHE_LINE_SIZE>
+	{
+		Stack<StackData> nodes;
+		char padding[CACHE_LINE_SIZE];
+	};
+	std::vector<ThreadStack*> remainingNodes;	// one stack per thread
+
+	/// allocates a stack for each of the omp_get_max_threads() threads. each thread allocates its own stack.
+	void createStacks()
+	{
+		deleteStacks();
+
+		int threadCount = omp_get_max_threads();
+		remainingNodes.assign(threadCount, (ThreadStack*)NULL);
+
+		#pragma omp parallel num_threads(threadCount)
+		{
+			ThreadStack* stack = new ThreadStack();
+			stack->nodes.reserve(height > 0 ? height : 1);
+			remainingNodes[omp_get_thread_num()] = stack;
+		}
+
+		// the runtime might have started less threads
+		for (int i = 0; i < threadCount; ++i)
+		{
+			if(remainingNodes[i]) continue;
+			remainingNodes[i] = new ThreadStack();
+			remainingNodes[i]->nodes.reserve(height > 0 ? height : 1);
+		}
+	}
+
+	void deleteStacks()
+	{
+		for (size_t i = 0; i < remainingNodes.size(); ++i)
+		{
+			delete remainingNodes[i];
+		}
+		remainingNodes.clear();
+	}
+
+	/// copy of the node and triangle arrays in placed memory (see NumaPlacement). one copy per NUMA node with the REPLICATE policy.
+	struct Replica
+	{
+		Node* nodes;
+		Triangle* triangles;
+	};
+	std::vector<Replica> replicas;
+	unsigned long replicaTriangleCount;
+
+	NodeAccessTrace* accessTrace;	// NULL if the accesses are not logged
+
+	/// copies the arrays after construction. the builder wrote them from one thread, so they are on the memory of one socket.
+	void placeArrays()
+	{
+		releaseArrays();
+		if(!NumaPlacement::enabled() || triangles->empty()) return;
+
+		bool replicate = NumaPlacement::policy == NumaPlacement::REPLICATE;
+		replicas.resize(replicate ? NumaPlacement::getNodeCount() : 1);
+		replicaTriangleCount = triangles->size();
+
+		for (int i = 0; i < (int)replicas.size(); ++i)
+		{
+			int node = replicate ? i : -1;
+			replicas[i].nodes = NumaPlacement::copy(root, nodeCount, node);
+			replicas[i].triangles = NumaPlacement::copy(&(*triangles)[0], replicaTriangleCount, node);
+		}
+
+		// only the copies are traversed
+		delete[] root;
+		root = NULL;
+	}
+
+	void releaseArrays()
+	{
+		for (size_t i = 0; i < replicas.size(); ++i)
+		{
+			NumaPlacement::release(replicas[i].nodes, nodeCount * sizeof(Node));
+			NumaPlacement::release(replicas[i].triangles, replicaTriangleCount * sizeof(Triangle));
+		}
+		replicas.clear();
+	}
+
+	/// node and triangle arrays to be traversed by the calling thread
+	inline void getArrays(Node*& nodes, Triangle*& tris)
+	{
+		if(replicas.empty())
+		{
+			nodes = root;
+			tris = &(*this->triangles)[0];
+			return;
+		}
+
+		const Replica& replica = replicas.size() > 1 ? replicas[NumaPlacement::getCurrentNode() % replicas.size()] : replicas[0];
+		nodes = replica.nodes;
+		tris = replica.triangles;
+	}
 
 	XHierarchyConstructionStrategy<Node> *conStrat;
 	Node *root;
 	unsigned long nodeCount;
+	unsigned int height;
 	AABBox bounds;
 	std::vector<Triangle>* triangles;
 	
 	virtual void updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const Node *bounds, qfloat& t_near, qfloat& t_far) = 0;
 
 private:
+	// the restart trail has one bit per tree level
+	inline bool trailFitsTreeHeight() const { return height < sizeof(unsigned long)*8; }
+
+	/// traverses one packet. out.lanes points to the lane counters of this packet.
+	void intersectPacket(PackedRay& ray, IntersectDetails& out)
+	{
+		qfloat tnear = 0.0f;
+		qfloat tfar = ray.t;
+
+		bounds.clip(ray, tnear, tfar);
+
+		if ((tnear > tfar).allTrue())
+		{
+			return;	// all rays miss bounds
+		}
+
+		qmask reverse[3];
+		reverse[0] = ray.dirrcp.x < 0.0f;
+		reverse[1] = ray.dirrcp.y < 0.0f;
+		reverse[2] = ray.dirrcp.z < 0.0f;
+
+		Node* nodes;
+		Triangle* tris;
+		getArrays(nodes, tris);
+
+		#ifdef TRAVERSE_ITERATIVE
+			#ifdef TRAVERSE_SHORTSTACK
+				if(trailFitsTreeHeight() && !accessTrace)
+				{
+					traverse_shortstack(ray, nodes, tris, tnear, tfar, reverse, out);
+					return;
+				}
+			#endif
+			traverse_iterative(ray, nodes, tris, tnear, tfar, reverse, out);
+			if(accessTrace) accessTrace->endPacket();
+		#else
+			traverse_recursive(ray, nodes, nodes, tris, tnear, tfar, reverse, out);
+		#endif
+	}
+
+	/*
+		iterative traversal with a short stack of SHORT_STACK_SIZE entries per ray packet.
+		
+		the trail holds one bit per tree level. a set bit means that the first child on this level has been
+		finished and the second child is being traversed. when a subtree is finished, the bit of its level is
+		incremented (carrying over to finished parent levels), so the lowest set bit tells the level to continue on.
+		when the short stack is empty the traversal restarts at the root node and follows the trail down to that level.
+
+		the whole traversal state of a packet is kept in TraversalState, so several packets can be traversed
+		interleaved by one thread (see intersectPackets).
+	*/
+	struct TraversalState : public SIMDmemAligned
+	{
+		PackedRay* ray;
+		Node* node;
+		Triangle* triangles;
+		LaneCounters* lanes;	// NULL if the cost per lane is not counted
+		qfloat t_near;
+		qfloat t_far;
+		qfloat t_near_root;	// active ray segment at the root node for restarts
+		qfloat t_far_root;
+		qmask reverse[3];
+
+		// ring buffer. the oldest entry is overwritten when the stack is full.
+		StackData shortStack[SHORT_STACK_SIZE];
+		unsigned int stackTop;
+		unsigned int stackCount;
+
+		unsigned long level;
+		unsigned long trail;
+	};
+
+	inline void beginTraversal(TraversalState& s, PackedRay& ray, Node* rootNode, Triangle* tris, LaneCounters* lanes, const qfloat& t_near, const qfloat& t_far, const qmask reverse[3])
+	{
+		s.ray = &ray;
+		s.node = rootNode;
+		s.triangles = tris;
+		s.lanes = lanes;
+		s.t_near = s.t_near_root = t_near;
+		s.t_far = s.t_far_root = t_far;
+		s.reverse[0] = reverse[0];
+		s.reverse[1] = reverse[1];
+		s.reverse[2] = reverse[2];
+		s.stackTop = 0;
+		s.stackCount = 0;
+		s.level = 1ul << height;
+		s.trail = 0;
+	}
+
+	// tests the current node of a packet and moves on to the next node. returns false when the traversal is finished.
+	inline bool traversalStep(TraversalState& s, Node* rootNode, IntersectDetails& out)
+	{
+		PackedRay& ray = *s.ray;
+		Node* currentNode = s.node;
+
+		if(s.lanes) LaneCounters::add(s.lanes->nodeVisits, (s.t_near <= s.t_far).mask());
+
+		updateActiveRaySegment(ray, s.reverse, currentNode, s.t_near, s.t_far);
+		++out.rayNodeIntersections;
+
+		bool finished = (s.t_near > s.t_far).allTrue()
+			#ifdef TRAVERSE_ORDERED
+				|| (s.t_near > ray.t).allTrue()
+			#endif
+			;
+
+		if (!finished && currentNode->isLeaf())
+		{
+			// leaf node -> intersect with geometry
+			if(s.lanes) LaneCounters::add(s.lanes->triangleTests, (s.t_near <= s.t_far).mask());
+			s.triangles[currentNode->getGeomIndex()].intersect(ray);
+			finished = true;
+		}
+
+		if (!finished)
+		{
+			// inner node. descend one level.
+			s.level >>= 1;
+
+			x_node_child_id_t child = currentNode->getChildId();
+			Node* first = rootNode + child;
+			Node* second = rootNode + child+1;
+
+			#ifdef TRAVERSE_ORDERED
+				// ordered traversal. traverse near node first.
+				if(s.reverse[currentNode->getSplitAxis()].mask())
+				{
+					first = rootNode + child+1;
+					second = rootNode + child;
+				}
+			#endif
+
+			if (s.trail & s.level)
+			{
+				// first child has been finished before restart
+				s.node = second;
+			}
+			else
+			{
+				// push second child. write directly to stack through reference
+				StackData& sd = s.shortStack[s.stackTop];
+				sd.node = second;
+				sd.t_near = s.t_near;
+				sd.t_far = s.t_far;
+				s.stackTop = (s.stackTop + 1) % SHORT_STACK_SIZE;
+				if(s.stackCount < SHORT_STACK_SIZE) ++s.stackCount;
+
+				s.node = first;
+			}
+
+			return true;
+		}
+
+		// subtree finished. clear the bits of the levels below and increment the current level
+		const unsigned long rootLevel = 1ul << height;
+		s.trail = (s.trail & (0ul - s.level)) + s.level;
+		if(s.trail & rootLevel) return false;	// root finished
+
+		// continue on the lowest unfinished level
+		s.level = s.trail & (0ul - s.trail);
+
+		if(s.stackCount != 0)
+		{
+			s.stackTop = (s.stackTop + SHORT_STACK_SIZE - 1) % SHORT_STACK_SIZE;
+			--s.stackCount;
+
+			StackData& sd = s.shortStack[s.stackTop];
+			s.node = sd.node;
+			s.t_near = sd.t_near;
+			s.t_far = sd.t_far;
+		}
+		else
+		{
+			// stack entry has been dropped. restart at the root node and follow the trail.
+			s.node = rootNode;
+			s.level = rootLevel;
+			s.t_near = s.t_near_root;
+			s.t_far = s.t_far_root;
+		}
+
+		return true;
+	}
+
+	void traverse_shortstack(
+		PackedRay& ray,
+		Node* rootNode,
+		Triangle* tris,
+		qfloat& t_near_r,
+		qfloat& t_far_r,
+		const qmask reverse[3],
+		IntersectDetails& out
+	)
+	{
+		TraversalState state;
+		beginTraversal(state, ray, rootNode, tris, out.lanes, t_near_r, t_far_r, reverse);
+
+		while(traversalStep(state, rootNode, out));
+	}
+
+	/*
+		traverses up to INTERLEAVED_PACKETS packets at once. the packets are advanced round-robin by one node
+		and the next node of each packet is prefetched, so the cache miss of one packet overlaps with the work on the others.
+	*/
+	void traverse_interleaved(
+		PackedRay** rays,
+		unsigned int count,
+		LaneCounters* lanes,
+		IntersectDetails& out
+	)
+	{
+		assert(count <= INTERLEAVED_PACKETS);
+
+		TraversalState states[INTERLEAVED_PACKETS];
+		unsigned int active[INTERLEAVED_PACKETS];
+		unsigned int activeCount = 0;
+
+		Node* nodes;
+		Triangle* tris;
+		getArrays(nodes, tris);
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			PackedRay& ray = *rays[i];
+
+			qfloat tnear = 0.0f;
+			qfloat tfar = ray.t;
+
+			bounds.clip(ray, tnear, tfar);
+
+			if ((tnear > tfar).allTrue()) continue;	// all rays miss bounds
+
+			qmask reverse[3];
+			reverse[0] = ray.dirrcp.x < 0.0f;
+			reverse[1] = ray.dirrcp.y < 0.0f;
+			reverse[2] = ray.dirrcp.z < 0.0f;
+
+			beginTraversal(states[i], ray, nodes, tris, lanes ? lanes + i : NULL, tnear, tfar, reverse);
+			active[activeCount++] = i;
+		}
+
+		// round-robin over the unfinished packets. finished packets are removed by moving the last one into their slot.
+		unsigned int current = 0;
+		while(activeCount != 0)
+		{
+			TraversalState& s = states[active[current]];
+
+			if(traversalStep(s, nodes, out))
+			{
+				_mm_prefetch(reinterpret_cast<const char*>(s.node), _MM_HINT_T0);
+				++current;
+			}
+			else
+			{
+				active[current] = active[--activeCount];
+			}
+
+			if(current >= activeCount) current = 0;
+		}
+	}
+
 	void traverse_iterative(
 		PackedRay& ray,
 		Node* rootNode,
+		Triangle* tris,
 		qfloat& t_near_r,
 		qfloat& t_far_r,
 		const qmask reverse[3],
@@ -203,11 +602,8 @@ private:
 		qfloat t_near = t_near_r;
 		qfloat t_far = t_far_r;
 
-		#ifdef MULTITHREADING
-			Stack<StackData>& remainingNodes = this->remainingNodes[omp_get_thread_num()];
-		#else
-			Stack<StackData>& remainingNodes = this->remainingNodes;
-		#endif
+		assert(omp_get_thread_num() < (int)this->remainingNodes.size());
+		Stack<StackData>& remainingNodes = this->remainingNodes[omp_get_thread_num()]->nodes;
 		
 		remainingNodes.clear();
 
@@ -216,6 +612,9 @@ private:
 		// traverse near nodes and push far nodes onto stack
 		while(true)
 		{
+			if(out.lanes) LaneCounters::add(out.lanes->nodeVisits, (t_near <= t_far).mask());
+			if(accessTrace) accessTrace->node(currentNode - rootNode);
+
 			updateActiveRaySegment(ray, reverse, currentNode, t_near, t_far);
 			++out.rayNodeIntersections;
 
@@ -242,7 +641,9 @@ private:
 			if (currentNode->isLeaf())
 			{
 				// leaf node -> intersect with geometry
-				(*this->triangles)[currentNode->getGeomIndex()].intersect(ray);
+				if(out.lanes) LaneCounters::add(out.lanes->triangleTests, (t_near <= t_far).mask());
+				if(accessTrace) accessTrace->triangle(currentNode->getGeomIndex());
+				tris[currentNode->getGeomIndex()].intersect(ray);
 
 				// traverse node from stack
 				
@@ -291,6 +692,7 @@ private:
 		PackedRay& ray,
 		Node* node,
 		Node* rootNode,
+		Triangle* tris,
 		qfloat& t_near_r,
 		qfloat& t_far_r,
 		const qmask reverse[3],
@@ -301,6 +703,8 @@ private:
 		qfloat t_near = t_near_r;
 		qfloat t_far = t_far_r;
 
+		if(out.lanes) LaneCounters::add(out.lanes->nodeVisits, (t_near <= t_far).mask());
+
 		updateActiveRaySegment(ray, reverse, node, t_near, t_far);
 		++out.rayNodeIntersections;
 		
@@ -317,7 +721,8 @@ private:
 		if (node->isLeaf())
 		{
 			// leaf node
-			(*this->triangles)[node->getGeomIndex()].intersect(ray);
+			if(out.lanes) LaneCounters::add(out.lanes->triangleTests, (t_near <= t_far).mask());
+			tris[node->getGeomIndex()].intersect(ray);
 			
 			return;
 		}
@@ -330,17 +735,17 @@ private:
 			// ordered traversal for ray packages with uniform direction signs. traverse near node first.
 			if(reverse[node->getSplitAxis()].allTrue())
 			{
-				traverse_recursive(ray, rootNode + child + 1, rootNode, t_near, t_far, reverse, out);
-				traverse_recursive(ray, rootNode + child, rootNode, t_near, t_far, reverse, out);
+				traverse_recursive(ray, rootNode + child + 1, rootNode, tris, t_near, t_far, reverse, out);
+				traverse_recursive(ray, rootNode + child, rootNode, tris, t_near, t_far, reverse, out);
 			}
 			else
 			{
-				traverse_recursive(ray, rootNode + child, rootNode, t_near, t_far, reverse, out);
-				traverse_recursive(ray, rootNode + child + 1, rootNode, t_near, t_far, reverse, out);
+				traverse_recursive(ray, rootNode + child, rootNode, tris, t_near, t_far, reverse, out);
+				traverse_recursive(ray, rootNode + child + 1, rootNode, tris, t_near, t_far, reverse, out);
 			}
 		#else
-			traverse_recursive(ray, rootNode + child, rootNode, t_near, t_far, reverse, out);
-			traverse_recursive(ray, rootNode + child+1, rootNode, t_near, t_far, reverse, out);
+			traverse_recursive(ray, rootNode + child, rootNode, tris, t_near, t_far, reverse, out);
+			traverse_recursive(ray, rootNode + child+1, rootNode, tris, t_near, t_far, reverse, out);
 		#endif
 	}
 };
@@ -361,5 +766,45 @@ protected:
 	virtual void updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const BVHNode *node, qfloat& t_near, qfloat& t_far);
 };
 
+class DualSlabHierarchy : public XHierarchy<DSHNode>
+{
+public:
+	DualSlabHierarchy(XHierarchyConstructionStrategy<DSHNode>* conStrat) : XHierarchy<DSHNode>(conStrat) {}
+protected:
+	virtual void updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const DSHNode *node, qfloat& t_near, qfloat& t_far);
+};
+
+class HybridHierarchySpatialMedianCut;
+
+// the boxes of the box nodes are known by HybridHierarchy only (see HybridHierarchy::analyze)
+template<>
+inline bool XHierarchy<HybridNode>::analyze(HierarchyStatistics&) { return false; }
+
+/*
+	hierarchy of slab nodes and box nodes (see HybridNode). the builder decides which nodes get a box.
+	the boxes are kept in an array of their own, which is neither placed (see NumaPlacement) nor traced.
+*/
+class HybridHierarchy : public XHierarchy<HybridNode>
+{
+public:
+	HybridHierarchy(HybridHierarchySpatialMedianCut* conStrat);
+
+	virtual SceneConstructionDetails construct(std::vector<Triangle>* geometries);
+
+	virtual unsigned long getComputedMemoryUsage() const
+	{
+		return XHierarchy<HybridNode>::getComputedMemoryUsage() + HybridBox::memSize * boxes.size();
+	}
+
+	virtual bool analyze(HierarchyStatistics& out);
+
+protected:
+	virtual void updateActiveRaySegment(const PackedRay &ray, const qmask reverse[3], const HybridNode *node, qfloat& t_near, qfloat& t_far);
+
+private:
+	HybridHierarchySpatialMedianCut* builder;
+	std::vector<HybridBox> boxes;	// of the box nodes, by HybridNode::boxIndex
+};
+
 #endif
 
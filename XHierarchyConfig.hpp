@@ -8,6 +8,19 @@
 // traverse near node first
 #define TRAVERSE_ORDERED	// <-- comment this out or in
 
+// iterative traversal with a small fixed-size stack per ray packet instead of a stack of tree height per thread.
+// entries that don't fit into the short stack are dropped and found again by restarting at the root node (restart trail).
+// needs TRAVERSE_ITERATIVE.
+//#define TRAVERSE_SHORTSTACK	// <-- comment this out or in
+
+// number of entries in the short stack
+#define SHORT_STACK_SIZE 8
+
+// number of ray packets one thread traverses interleaved (Scene::intersectPackets). the packets are advanced
+// round-robin one node at a time and the next node of each packet is prefetched. each packet uses the short stack
+// traversal state. needs TRAVERSE_ITERATIVE. 1 disables interleaving.
+#define INTERLEAVED_PACKETS 1	// <-- set this to 1, 2, 4, ...
+
 // type of node ids. maximum triangle count per scene is 67.108.864 for 32-bit int and 288.230.376.151.711.744 for 64-bit long :)
 #if 1	// <-- set this to 0 or 1
 	typedef unsigned long x_node_child_id_t;
@@ -1,13 +1,8 @@
 #include <iostream>
+#include <queue>
 
 #include "XHierarchySpatialMedianCut.hpp"
 #include "Triangle.hpp"
-#include "TimeMeasurement.hpp"
-
-#include "TestConfig.hpp"
-
-extern bool makeStats;
-extern TimeMeasurement constructionTimeMeasurement;
 
 void SingleSlabHierarchySpatialMedianCut::setupRootNode(SSHNode& node, const AABBox &bounds)
 {
@@ -18,38 +13,21 @@ void SingleSlabHierarchySpatialMedianCut::setupRootNode(SSHNode& node, const AAB
 	goal: carve parent bounds by one side
 	for each side: carve parent bounds and save the side if resulting volume is the smallest
 */
-AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out)
+template<typename Node>
+static AABBox setSlabVolume(Node& node, const AABBox& parentBounds, const AABBox& bounds)
 {
-#if 1
 	AABBox candidateBounds(parentBounds);
 	candidateBounds.min.x = bounds.min.x;
 	AABBox nodeBounds(candidateBounds);
 	float a = candidateBounds.surfaceArea();
-	node.setSlab(SSHNode::AXIS_X, true, bounds.min.x);
-#else
-	AABBox nodeBounds;
-	AABBox candidateBounds(parentBounds);
-	float a = parentBounds.surfaceArea();
+	node.setSlab(Node::AXIS_X, true, bounds.min.x);
 
-	// initialize
-	node.setSlab(SSHNode::AXIS_X, true, bounds.min.x);
-
-	// x axis
-	candidateBounds.min.x = bounds.min.x;
-	nodeBounds = candidateBounds;
-	if ( candidateBounds.surfaceArea() < a )
-	{
-		a = candidateBounds.surfaceArea();
-		//node.setSlab(SSHNode::AXIS_X, true, bounds.min.x);
-		nodeBounds = candidateBounds;
-	}
-#endif
 	candidateBounds = parentBounds;
 	candidateBounds.max.x = bounds.max.x;
 	if ( candidateBounds.surfaceArea() < a )
 	{
 		a = candidateBounds.surfaceArea();
-		node.setSlab(SSHNode::AXIS_X, false, bounds.max.x);
+		node.setSlab(Node::AXIS_X, false, bounds.max.x);
 		nodeBounds = candidateBounds;
 	}
 	// y axis
@@ -58,7 +36,7 @@ AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const A
 	if ( candidateBounds.surfaceArea() < a )
 	{
 		a = candidateBounds.surfaceArea();
-		node.setSlab(SSHNode::AXIS_Y, true, bounds.min.y);
+		node.setSlab(Node::AXIS_Y, true, bounds.min.y);
 		nodeBounds = candidateBounds;
 	}
 	candidateBounds = parentBounds;
@@ -66,7 +44,7 @@ AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const A
 	if ( candidateBounds.surfaceArea() < a )
 	{
 		a = candidateBounds.surfaceArea();
-		node.setSlab(SSHNode::AXIS_Y, false, bounds.max.y);
+		node.setSlab(Node::AXIS_Y, false, bounds.max.y);
 		nodeBounds = candidateBounds;
 	}
 	// z axis
@@ -75,7 +53,7 @@ AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const A
 	if ( candidateBounds.surfaceArea() < a )
 	{
 		a = candidateBounds.surfaceArea();
-		node.setSlab(SSHNode::AXIS_Z, true, bounds.min.z);
+		node.setSlab(Node::AXIS_Z, true, bounds.min.z);
 		nodeBounds = candidateBounds;
 	}
 	candidateBounds = parentBounds;
@@ -83,56 +61,53 @@ AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const A
 	if ( candidateBounds.surfaceArea() < a )
 	{
 		a = candidateBounds.surfaceArea();
-		node.setSlab(SSHNode::AXIS_Z, false, bounds.max.z);
+		node.setSlab(Node::AXIS_Z, false, bounds.max.z);
 		nodeBounds = candidateBounds;
 	}
 
-	if(makeStats)
-	{
-		constructionTimeMeasurement.pause();
-
-		// compute surface ratio for debug/test
-#ifdef BIGFLOAT_SURFACE_COMPUTATION
-		BigFloat bvh = bounds.surfaceAreaPrecise();
-		BigFloat ssh = nodeBounds.surfaceAreaPrecise();
+	return nodeBounds;
+}
 
-		static long cur = 0;
-		static long count = out.innerNodes + out.leafNodes;
-		if(count != out.innerNodes + out.leafNodes)
-		{
-			count = out.innerNodes + out.leafNodes;
-			cur = 0;
-		}
-		++cur;
-		if(cur % 1000 == 0) std::cout << cur << "/" << count << std::endl;
+AABBox SingleSlabHierarchySpatialMedianCut::setNodeVolume(SSHNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out)
+{
+	return setSlabVolume(node, parentBounds, bounds);
+}
 
-		if(bvh.compare(&BigFloat(0.0)) < 0 && ssh.compare(&BigFloat(0.0)) < 0)
-		{
-			assert(ssh.compare(&bvh) <= 0);
-			out.bshSurfaceRatio += (ssh / bvh) / BigFloat(out.innerNodes+out.leafNodes);
-		}
-		else
-		{
-			out.bshSurfaceRatio += BigFloat(1.0) / BigFloat(out.innerNodes+out.leafNodes);
-		}
-#else
-		long double bvh = bounds.surfaceAreaPrecise();
-		long double ssh = nodeBounds.surfaceAreaPrecise();
+void DualSlabHierarchySpatialMedianCut::setupRootNode(DSHNode& node, const AABBox &bounds)
+{
+	node.setSlabs(DSHNode::AXIS_X, false, bounds.max.x, DSHNode::AXIS_X, true, bounds.min.x);
+}
 
-		if(bvh > 0 && ssh > 0)
-		{
-			assert(ssh >= bvh);
-			out.bshSurfaceRatio += (ssh / bvh) / (long double)(out.innerNodes+out.leafNodes);
-		}
-		else
+/*
+	goal: carve parent bounds by two sides
+	for each pair of the six sides: carve parent bounds and save the pair if resulting volume is the smallest.
+	side 2*axis is the lower side (near), side 2*axis+1 the upper side.
+*/
+AABBox DualSlabHierarchySpatialMedianCut::setNodeVolume(DSHNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out)
+{
+	AABBox nodeBounds;
+	float a = 0.0f;
+	for (int first = 0; first < 6; ++first)
+	{
+		for (int second = first+1; second < 6; ++second)
 		{
-			out.bshSurfaceRatio += (long double)(1.0) / (long double)(out.innerNodes+out.leafNodes);
+			AABBox candidateBounds(parentBounds);
+			if(first & 1) candidateBounds.max[first/2] = bounds.max[first/2];
+			else candidateBounds.min[first/2] = bounds.min[first/2];
+			if(second & 1) candidateBounds.max[second/2] = bounds.max[second/2];
+			else candidateBounds.min[second/2] = bounds.min[second/2];
+
+			if ( (first == 0 && second == 1) || candidateBounds.surfaceArea() < a )
+			{
+				a = candidateBounds.surfaceArea();
+				node.setSlabs(
+					(DSHNode::AXIS)(first/2), !(first & 1), (first & 1) ? bounds.max[first/2] : bounds.min[first/2],
+					(DSHNode::AXIS)(second/2), !(second & 1), (second & 1) ? bounds.max[second/2] : bounds.min[second/2]);
+				nodeBounds = candidateBounds;
+			}
 		}
-#endif
-
-		constructionTimeMeasurement.resume();
 	}
-	
+
 	return nodeBounds;
 }
 
@@ -150,3 +125,107 @@ AABBox BoundingVolumeHierarchySpatialMedianCut::setNodeVolume(BVHNode& node, con
 	return bounds;
 }
 
+
+void HybridHierarchySpatialMedianCut::construct(std::vector<Triangle> &globalgeom, const AABBox &bounds, HybridNode* nodes, SceneConstructionDetails& out)
+{
+	unsigned long nodeCount = 2*globalgeom.size() - 1;
+	firstNode = nodes;
+	tightBounds.assign(nodeCount, AABBox());
+
+	XHierarchySpatialMedianCut<HybridNode>::construct(globalgeom, bounds, nodes, out);
+	assignVolumes(bounds, nodes, nodeCount);
+
+	firstNode = NULL;
+	std::vector<AABBox>().swap(tightBounds);
+
+	std::cout << "hybrid hierarchy: " << boxes.size() << " of " << nodeCount << " nodes are box nodes" << std::endl;
+}
+
+void HybridHierarchySpatialMedianCut::takeBoxes(std::vector<HybridBox>& boxes)
+{
+	boxes.clear();
+	boxes.swap(this->boxes);
+}
+
+// the volumes are assigned after the tree is built. the nodes only remember the bounds of their triangles.
+void HybridHierarchySpatialMedianCut::setupRootNode(HybridNode& node, const AABBox &bounds)
+{
+	node.flags = 0;
+}
+
+AABBox HybridHierarchySpatialMedianCut::setNodeVolume(HybridNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out)
+{
+	node.flags = 0;
+	tightBounds[&node - firstNode] = bounds;
+	return bounds;
+}
+
+void HybridHierarchySpatialMedianCut::assignVolumes(const AABBox& bounds, HybridNode* nodes, unsigned long nodeCount)
+{
+	boxes.clear();
+
+	unsigned long maxBoxes = nodeCount;
+	if(memoryBudget)
+	{
+		unsigned long slabMemory = HybridNode::memSize * nodeCount;
+		maxBoxes = memoryBudget > slabMemory ? (memoryBudget - slabMemory) / HybridBox::memSize : 0;
+		if(maxBoxes > nodeCount) maxBoxes = nodeCount;
+	}
+
+	// height of the subtrees. the children are stored behind their parents.
+	std::vector<unsigned int> heights(nodeCount, 0);
+	for (long i = (long)nodeCount-1; i >= 0; --i)
+	{
+		if(nodes[i].isLeaf()) continue;
+		x_node_child_id_t child = nodes[i].getChildId();
+		heights[i] = 1 + (heights[child] > heights[child+1] ? heights[child] : heights[child+1]);
+	}
+
+	double rootArea = bounds.surfaceArea();
+	if(rootArea <= 0.0) rootArea = 1.0;
+
+	// box the traversal tests for each node
+	std::vector<AABBox> nodeBounds(nodeCount);
+
+	// the root node is hit by every ray which hits the scene bounds
+	nodes[0].setSlab(HybridNode::AXIS_X, false, bounds.max.x);
+	nodeBounds[0] = bounds;
+
+	// saving of a box minus its cost for the nodes whose parent is decided
+	std::priority_queue<std::pair<double, x_node_child_id_t> > candidates;
+
+	x_node_child_id_t decided = 0;
+	while(true)
+	{
+		if(!nodes[decided].isLeaf())
+		{
+			double parentArea = nodeBounds[decided].surfaceArea() / rootArea;
+			x_node_child_id_t child = nodes[decided].getChildId();
+			for (x_node_child_id_t c = child; c < child+2; ++c)
+			{
+				nodeBounds[c] = setSlabVolume(nodes[c], nodeBounds[decided], tightBounds[c]);
+
+				double culled = (nodeBounds[c].surfaceArea() - tightBounds[c].surfaceArea()) / rootArea;
+				double saving = culled * (2.0 * heights[c] + HYBRID_TRIANGLE_COST);
+				double cost = (HYBRID_BOX_COST - 1.0) * parentArea;
+				candidates.push(std::make_pair(saving - cost, c));
+			}
+		}
+
+		if(candidates.empty()) break;
+
+		decided = candidates.top().second;
+		bool box = candidates.top().first > 0.0 && boxes.size() < maxBoxes;
+		candidates.pop();
+
+		if(box)
+		{
+			nodes[decided].setBox(boxes.size());
+			HybridBox b;
+			b.min = tightBounds[decided].min;
+			b.max = tightBounds[decided].max;
+			boxes.push_back(b);
+			nodeBounds[decided] = tightBounds[decided];
+		}
+	}
+}
@@ -217,5 +217,54 @@ protected:
 	virtual AABBox setNodeVolume(BVHNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out);
 };
 
+class DualSlabHierarchySpatialMedianCut : public XHierarchySpatialMedianCut<DSHNode>
+{
+protected:
+	virtual void setupRootNode(DSHNode& node, const AABBox &bounds);
+	virtual AABBox setNodeVolume(DSHNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out);
+};
+
+// cost of a box test and of a triangle test in slab tests. used to decide which nodes of the hybrid hierarchy get a box.
+#define HYBRID_BOX_COST 3.0
+#define HYBRID_TRIANGLE_COST 4.0
+
+/*
+	hybrid hierarchy (see HybridNode). the spatial median cut builds the tree, then the volumes are assigned from the root down.
+
+	every node starts as a slab node. a box makes the node cost HYBRID_BOX_COST instead of one slab test for each ray that
+	hits its parent, and it saves the tests below the node for the rays that hit its slab volume but miss its tight box.
+	the saving is estimated with the surface areas and the height of the subtree (two node tests per level and a triangle test).
+	the nodes are decided best first, a node as soon as its parent is decided, so boxes go to the upper nodes which most rays
+	visit and the deep nodes stay slabs. nodes get boxes while the saving is larger than the cost and the boxes fit into the budget.
+*/
+class HybridHierarchySpatialMedianCut : public XHierarchySpatialMedianCut<HybridNode>
+{
+public:
+	/// memoryBudget: bytes of the nodes and the boxes. 0 for no limit.
+	HybridHierarchySpatialMedianCut(unsigned long memoryBudget = 0) : memoryBudget(memoryBudget), firstNode(NULL) {}
+
+	virtual void construct(
+		std::vector<Triangle> &globalgeom,
+		const AABBox &bounds,
+		HybridNode* nodes,
+		SceneConstructionDetails& out
+	);
+
+	/// moves the boxes of the last construction to boxes
+	void takeBoxes(std::vector<HybridBox>& boxes);
+
+protected:
+	virtual void setupRootNode(HybridNode& node, const AABBox &bounds);
+	virtual AABBox setNodeVolume(HybridNode& node, const AABBox& parentBounds, const AABBox& bounds, SceneConstructionDetails& out);
+
+private:
+	unsigned long memoryBudget;
+	HybridNode* firstNode;	// of the nodes array during the construction
+	std::vector<AABBox> tightBounds;	// bounds of the triangles below each node
+	std::vector<HybridBox> boxes;
+
+	void assignVolumes(const AABBox& bounds, HybridNode* nodes, unsigned long nodeCount);
+};
+
 #endif
 
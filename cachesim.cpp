@@ -0,0 +1,188 @@
+/*
+	replays node access traces written with "rayreplay -nodeTrace=<file>" through a simulated set associative cache
+	with LRU replacement. the node array and the triangle array start at cache line boundaries. an entry touches
+	every line its bytes overlap, so the node size decides how many lines a node access costs.
+	the same trace can be replayed with another node size, e.g. the 12 bytes of a packed SSH node instead of the 16 bytes of the padded one.
+
+	./cachesim [-lineSize=<bytes>] [-associativity=<ways>] [-capacity=<KB>] [-nodeSize=<bytes>] [-nodesOnly] <tracefile> [<tracefile> ...]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <string.h>
+#include <stdlib.h>
+
+#include "NodeAccessTrace.hpp"
+
+using namespace std;
+
+// entries read from the file at once
+#define READ_ENTRIES 65536
+
+const char* getArgument(int argc, char** argv, const char* name)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strncmp(argv[i], name, strlen(name))) return &argv[i][strlen(name)+1];
+	}
+	return NULL;
+}
+
+void printUsageAndExit()
+{
+	std::cout << "\n\nUsage:\n"
+		<< "./cachesim [-lineSize=<bytes>] [-associativity=<ways>] [-capacity=<KB>] [-nodeSize=<bytes>] [-nodesOnly] <tracefile> [<tracefile> ...]\n\n"
+		<< "tracefile: written by rayreplay -nodeTrace=<file>\n\n"
+		<< "lineSize: bytes per cache line (default 64)\n\n"
+		<< "associativity: lines per set (default 8). 0 for a fully associative cache.\n\n"
+		<< "capacity: size of the cache in KB (default 32)\n\n"
+		<< "nodeSize: bytes per node instead of the node size of the trace\n\n"
+		<< "nodesOnly: ignore the triangle accesses, so the nodes have the cache to themselves\n";
+	exit(1);
+}
+
+/// set associative cache with LRU replacement
+class Cache
+{
+public:
+	Cache(unsigned long lineCount, unsigned long ways) : ways(ways), sets(lineCount / ways), tags(lineCount, 0), lastUse(lineCount, 0), time(0) {}
+
+	/// returns true on a hit. the line is in the cache afterwards.
+	bool access(unsigned long line)
+	{
+		++time;
+		unsigned long first = (line % sets) * ways;
+		unsigned long victim = first;
+		for (unsigned long i = first; i < first + ways; ++i)
+		{
+			// lastUse 0 marks an empty way
+			if(lastUse[i] != 0 && tags[i] == line)
+			{
+				lastUse[i] = time;
+				return true;
+			}
+			if(lastUse[i] < lastUse[victim]) victim = i;
+		}
+		tags[victim] = line;
+		lastUse[victim] = time;
+		return false;
+	}
+
+private:
+	unsigned long ways;
+	unsigned long sets;
+	std::vector<unsigned long> tags;
+	std::vector<unsigned long> lastUse;
+	unsigned long time;
+};
+
+struct AccessCounts
+{
+	unsigned long accesses;
+	unsigned long lines;	// line accesses. a node can overlap two lines.
+	unsigned long misses;
+	std::set<unsigned long> touched;	// distinct lines
+
+	AccessCounts() : accesses(0), lines(0), misses(0) {}
+
+	void print(const char* name, unsigned long packets) const
+	{
+		std::cout << "  " << name << ": " << accesses << " accesses, " << lines << " line accesses, "
+			<< misses << " misses (" << (lines ? 100.0 * misses / lines : 0.0) << "%), "
+			<< (packets ? double(misses) / packets : 0.0) << " misses per packet, "
+			<< touched.size() << " distinct lines" << endl;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	if(argc < 2 || argv[argc-1][0] == '-') printUsageAndExit();
+
+	const char* arg = getArgument(argc, argv, "-lineSize");
+	unsigned long lineSize = arg ? atol(arg) : 64;
+	arg = getArgument(argc, argv, "-associativity");
+	unsigned long associativity = arg ? atol(arg) : 8;
+	arg = getArgument(argc, argv, "-capacity");
+	unsigned long capacity = (arg ? atol(arg) : 32) * 1024;
+	arg = getArgument(argc, argv, "-nodeSize");
+	unsigned long nodeSizeOverride = arg ? atol(arg) : 0;
+	bool nodesOnly = getArgument(argc, argv, "-nodesOnly") != NULL;
+
+	if(lineSize == 0 || capacity < lineSize)
+	{
+		std::cout << "the capacity has to hold at least one line" << endl;
+		return -1;
+	}
+	unsigned long lineCount = capacity / lineSize;
+	if(associativity == 0 || associativity > lineCount) associativity = lineCount;
+	if(lineCount % associativity != 0)
+	{
+		std::cout << "the " << lineCount << " lines cannot be divided into sets of " << associativity << endl;
+		return -1;
+	}
+
+	std::cout << "cache: " << capacity / 1024 << " KB, " << lineSize << " byte lines, " << associativity << " ways, "
+		<< lineCount / associativity << " sets, LRU" << endl;
+
+	int firstFile = argc-1;
+	while(firstFile > 1 && argv[firstFile-1][0] != '-') --firstFile;
+
+	std::vector<uint32_t> entries(READ_ENTRIES);
+	for (int f = firstFile; f < argc; ++f)
+	{
+		const char* fileName = argv[f];
+		FILE* file = fopen(fileName, "rb");
+		NodeTraceHeader header;
+		if(!file || !NodeAccessTrace::readHeader(file, header))
+		{
+			std::cout << "could not read node trace " << fileName << ". it has to be written by a rayreplay of the same build." << endl;
+			if(file) fclose(file);
+			return -1;
+		}
+
+		unsigned long nodeSize = nodeSizeOverride ? nodeSizeOverride : header.nodeSize;
+		unsigned long triangleBase = (header.nodeCount * nodeSize + lineSize-1) / lineSize * lineSize;
+
+		std::cout << fileName << ": " << header.packetCount << " packets, " << header.nodeCount << " nodes of " << nodeSize
+			<< " bytes (traced " << header.nodeSize << ", packed " << header.packedNodeSize << "), "
+			<< header.triangleCount << " triangles of " << header.triangleSize << " bytes" << endl;
+
+		Cache cache(lineCount, associativity);
+		AccessCounts nodes;
+		AccessCounts triangles;
+
+		size_t read;
+		while((read = fread(&entries[0], sizeof(uint32_t), entries.size(), file)) > 0)
+		{
+			for (size_t i = 0; i < read; ++i)
+			{
+				uint32_t entry = entries[i];
+				if(entry == NodeAccessTrace::END_OF_PACKET) continue;
+
+				bool triangle = (entry & NodeAccessTrace::TRIANGLE_FLAG) != 0;
+				if(triangle && nodesOnly) continue;
+
+				unsigned long index = entry & ~(uint32_t)NodeAccessTrace::TRIANGLE_FLAG;
+				unsigned long address = triangle ? triangleBase + index * header.triangleSize : index * nodeSize;
+				unsigned long size = triangle ? header.triangleSize : nodeSize;
+
+				AccessCounts& counts = triangle ? triangles : nodes;
+				++counts.accesses;
+				for (unsigned long line = address / lineSize; line <= (address + size - 1) / lineSize; ++line)
+				{
+					++counts.lines;
+					if(!cache.access(line)) ++counts.misses;
+					counts.touched.insert(line);
+				}
+			}
+		}
+		fclose(file);
+
+		nodes.print("nodes", header.packetCount);
+		if(!nodesOnly) triangles.print("triangles", header.packetCount);
+	}
+
+	return 0;
+}
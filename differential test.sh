@@ -0,0 +1,36 @@
+# renders and replays the models of "all models.txt" with the brute-force scene (no acceleration) and with each
+# hierarchy, and compares the hits and the images. the images and the differences are written to testresults/differential.
+# needs simdtrace, rayreplay and imagediff (make simdtrace rayreplay imagediff).
+# usage: sh "differential test.sh" [methods] [resolution]
+# exit code 1: a hierarchy misses or adds hits or its image differs
+
+METHODS=${1:-SVDH}
+RESOLUTION=${2:-320x240}
+OUT=testresults/differential
+MODELS=$(cat "all models.txt")
+
+mkdir -p $OUT images
+result=0
+for MODEL in $MODELS; do
+	NAME=$(basename $MODEL)
+
+	# reference image
+	./simdtrace -headless -mode=V -methods=N -resolution=$RESOLUTION $MODEL > /dev/null || exit $?
+	cp images/$NAME.ppm $OUT/$NAME.N.ppm
+
+	for METHOD in $(echo $METHODS | sed 's/./& /g'); do
+		./simdtrace -headless -mode=V -methods=$METHOD -resolution=$RESOLUTION $MODEL > /dev/null || exit $?
+		cp images/$NAME.ppm $OUT/$NAME.$METHOD.ppm
+		# the exit code of a pipe is the one of its last command, so the output is filtered afterwards
+		./imagediff -out=$OUT/$NAME.$METHOD.diff.ppm $OUT/$NAME.N.ppm $OUT/$NAME.$METHOD.ppm > $OUT/$NAME.$METHOD.diff.txt || result=1
+		grep -v "^reading" $OUT/$NAME.$METHOD.diff.txt
+	done
+
+	# the rays of the frame of the first method, traced by every method and compared with the brute-force scene
+	./simdtrace -headless -mode=V -methods=$(echo $METHODS | cut -c1) -resolution=$RESOLUTION -recordRays=$OUT/$NAME.rays $MODEL > /dev/null || exit $?
+	./rayreplay -methods=N$METHODS -repeat=1 $OUT/$NAME.rays || result=1
+	rm -f $OUT/$NAME.rays
+done
+
+if [ $result -ne 0 ]; then echo "differences found"; fi
+exit $result
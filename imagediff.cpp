@@ -0,0 +1,98 @@
+/*
+	compares two images written by "simdtrace -mode=V", e.g. of a hierarchy and of the brute-force scene (-methods=N).
+	writes an image which shows the reference dimmed and the differing pixels in red, brighter for larger differences.
+
+	./imagediff [-tolerance=<levels>] [-maxPixels=<count>] [-out=<file>] <reference.ppm> <candidate.ppm>
+*/
+
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Image.hpp"
+
+using namespace std;
+
+const char* getArgument(int argc, char** argv, const char* name)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strncmp(argv[i], name, strlen(name))) return &argv[i][strlen(name)+1];
+	}
+	return NULL;
+}
+
+void printUsageAndExit()
+{
+	std::cout << "\n\nUsage:\n"
+		<< "./imagediff [-tolerance=<levels>] [-maxPixels=<count>] [-out=<file>] <reference.ppm> <candidate.ppm>\n\n"
+		<< "tolerance: largest difference of a colour channel in 1/255 which is no difference (default 2)\n\n"
+		<< "maxPixels: number of differing pixels which are accepted (default 0)\n\n"
+		<< "out: image of the differences (default: no image)\n\n"
+		<< "the exit code is 1 if more than maxPixels pixels differ.\n";
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3 || argv[argc-1][0] == '-' || argv[argc-2][0] == '-') printUsageAndExit();
+
+	const char* arg = getArgument(argc, argv, "-tolerance");
+	float tolerance = (arg ? (float)atof(arg) : 2.0f) / 255.0f;
+	arg = getArgument(argc, argv, "-maxPixels");
+	long maxPixels = arg ? atol(arg) : 0;
+	const char* outFile = getArgument(argc, argv, "-out");
+
+	Image reference;
+	Image candidate;
+	reference.readPPM(argv[argc-2]);
+	candidate.readPPM(argv[argc-1]);
+
+	int width = reference.getWidth();
+	int height = reference.getHeight();
+	if(width != candidate.getWidth() || height != candidate.getHeight())
+	{
+		std::cout << "the images have different resolutions: " << width << "x" << height << " and "
+			<< candidate.getWidth() << "x" << candidate.getHeight() << endl;
+		return 1;
+	}
+
+	Image diff(width, height);
+	long pixels = 0;
+	float maxDifference = 0.0f;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			vec a = reference[y][x];
+			vec b = candidate[y][x];
+
+			float difference = 0.0f;
+			for (int c = 0; c < 3; ++c)
+			{
+				float d = fabsf(a[c] - b[c]);
+				if(d > difference) difference = d;
+			}
+			if(difference > maxDifference) maxDifference = difference;
+
+			if(difference > tolerance)
+			{
+				++pixels;
+				diff[y][x] = vec(0.5f + 0.5f * difference, 0.0f, 0.0f);
+			}
+			else
+			{
+				float gray = 0.1f * (a.x + a.y + a.z);
+				diff[y][x] = vec(gray, gray, gray);
+			}
+		}
+	}
+
+	if(outFile) diff.writePPM(outFile);
+
+	std::cout << argv[argc-1] << ": " << pixels << " of " << long(width) * height << " pixels differ from " << argv[argc-2]
+		<< " by more than " << tolerance * 255.0f << "/255, max difference " << maxDifference * 255.0f << "/255" << endl;
+
+	return pixels > maxPixels ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+	prints the metrics a running "simdtrace -metrics=<name>" publishes to shared memory, without stopping the renderer.
+
+	./livemetrics [-interval=<seconds>] [-count=<count>] [-stages] <name>
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+#include <stdlib.h>
+#ifndef WINDOWS
+	#include <unistd.h>
+#endif
+
+#include "LiveMetrics.hpp"
+
+using namespace std;
+
+const char* getArgument(int argc, char** argv, const char* name)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strncmp(argv[i], name, strlen(name))) return &argv[i][strlen(name)+1];
+	}
+	return NULL;
+}
+
+void printUsageAndExit()
+{
+	std::cout << "\n\nUsage:\n"
+		<< "./livemetrics [-interval=<seconds>] [-count=<count>] [-stages] <name>\n\n"
+		<< "name: shared memory segment of simdtrace -metrics=<name>, e.g. /simdtrace\n\n"
+		<< "interval: seconds between two reads (default 1)\n\n"
+		<< "count: number of printed frames (default 0: until the program is stopped)\n\n"
+		<< "stages: print the time of each render stage as well. needs the measurements of simdtrace.\n\n"
+		<< "a line is printed only if a new frame has been published since the last read.\n";
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2 || argv[argc-1][0] == '-') printUsageAndExit();
+
+	const char* arg = getArgument(argc, argv, "-interval");
+	double interval = arg ? atof(arg) : 1.0;
+	arg = getArgument(argc, argv, "-count");
+	long count = arg ? atol(arg) : 0;
+	bool stages = getArgument(argc, argv, "-stages") != NULL;
+
+	const char* name = argv[argc-1];
+	const LiveMetricsSegment* segment = LiveMetrics::attach(name);
+	if(!segment)
+	{
+		std::cout << "no metrics in shared memory " << name << ". start simdtrace -metrics=" << name << " first." << endl;
+		return -1;
+	}
+
+	unsigned long lastFrame = 0;
+	bool printed = false;
+	for (long printedCount = 0; count == 0 || printedCount < count; )
+	{
+		LiveMetricsValues values;
+		if(LiveMetrics::read(segment, values) && values.time > 0.0 && (!printed || values.frame != lastFrame))
+		{
+			double pixels = double(values.width) * values.height;
+			std::cout << std::fixed << std::setprecision(3)
+				<< values.time << " s frame " << values.frame << " " << values.model << " " << values.method
+				<< " " << values.width << "x" << values.height << " threads " << values.threads
+				<< ": " << values.framesPerSecond << " fps, " << values.raysPerSecond / 1e6 << " Mrays/s, frame " << values.frameTime << " s";
+			if(values.nodeTests) std::cout << ", " << 4.0 * values.nodeTests / pixels << " node tests/ray";
+			if(values.triangleTests) std::cout << ", " << values.triangleTests / pixels << " triangle tests/ray";
+			std::cout << ", nodes " << values.nodeMemory / 1024 << " KB, resident " << values.residentMemory / (1024*1024) << " MB" << endl;
+
+			if(stages)
+			{
+				for (int s = 0; s < StageTimer::STAGE_COUNT; ++s)
+				{
+					if(values.stageTimes[s] > 0.0) std::cout << "  " << StageTimer::getStageName(s) << ": " << values.stageTimes[s] << " s" << endl;
+				}
+			}
+
+			lastFrame = values.frame;
+			printed = true;
+			++printedCount;
+		}
+
+		#ifdef WINDOWS
+			Sleep((DWORD)(interval * 1000));
+		#else
+			// usleep takes less than a second
+			sleep((unsigned int)interval);
+			usleep((useconds_t)((interval - (unsigned int)interval) * 1e6));
+		#endif
+	}
+
+	LiveMetrics::detach(segment);
+	return 0;
+}
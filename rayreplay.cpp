@@ -0,0 +1,295 @@
+/*
+	replays a ray dump written with "simdtrace -recordRays=<file>" through the acceleration structures.
+	only the traversal is timed, without camera, shading and display. the hits of all methods are compared
+	with the first method and the distances with the recording.
+
+	./rayreplay [-methods=<methods>] [-threads=<threads>] [-repeat=<repeat>] [-nodeTrace=<file>] <dumpfile>
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "MultiThreading.hpp"
+#include "XHierarchy.hpp"
+#include "XHierarchySpatialMedianCut.hpp"
+#include "SimpleScene.hpp"
+#include "RecordingScene.hpp"
+#include "NodeAccessTrace.hpp"
+#include "TimeMeasurement.hpp"
+
+using namespace std;
+
+/// packets passed to Scene::intersectPackets at once, so hierarchies can traverse them interleaved
+#define REPLAY_BATCH 16
+
+/// relative tolerance for hit distances of the same triangle
+#define DISTANCE_TOLERANCE 1e-4f
+
+const char* getArgument(int argc, char** argv, const char* name)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strncmp(argv[i], name, strlen(name))) return &argv[i][strlen(name)+1];
+	}
+	return NULL;
+}
+
+void printUsageAndExit()
+{
+	std::cout << "\n\nUsage:\n"
+		<< "./rayreplay [-methods=<methods>] [-threads=<threads>] [-repeat=<repeat>] [-nodeTrace=<file>] <dumpfile>\n\n"
+		<< "dumpfile: written by simdtrace -recordRays=<dumpfile>\n\n"
+		<< "methods:\n"
+		<< "V: BVH - Bounding Volume Hierarchy\n"
+		<< "S: SSH - Single Slab Hierarchy\n"
+		<< "D: DSH - Dual Slab Hierarchy\n"
+		<< "H: Hybrid - SSH with box nodes where they pay off\n"
+		<< "N: No acceleration method\n"
+		<< "default: SV. the hits of each method are compared with the first method.\n"
+		<< "e.g. NSV checks SSH and BVH against the brute-force scene.\n\n"
+		<< "threads: number of threads (default: number of processors)\n\n"
+		<< "repeat: number of timed replays per method (default 5). the fastest one is reported.\n\n"
+		<< "nodeTrace: replays the packets once more on one thread in the order of the dump and writes the nodes and triangles\n"
+		<< "           each packet touches to <file>.<method>, e.g. kugeln.nodes.SSH. see cachesim.\n\n"
+		<< "the exit code is 1 if the hits of the methods differ.\n";
+	exit(1);
+}
+
+bool sameDistance(float a, float b)
+{
+	// infinite for rays without length. NaN for unused lanes.
+	if(a == b || (a != a && b != b)) return true;
+	return fabsf(a - b) <= DISTANCE_TOLERANCE * (fabsf(a) > 1.0f ? fabsf(a) : 1.0f);
+}
+
+Scene* createScene(char method)
+{
+	switch(method)
+	{
+	case 'V': return new BoundingVolumeHierarchy(new BoundingVolumeHierarchySpatialMedianCut());
+	case 'S': return new SingleSlabHierarchy(new SingleSlabHierarchySpatialMedianCut());
+	case 'D': return new DualSlabHierarchy(new DualSlabHierarchySpatialMedianCut());
+	case 'H': return new HybridHierarchy(new HybridHierarchySpatialMedianCut());
+	case 'N': return new SimpleScene();
+	}
+	std::cout << "unknown method: " << method << endl;
+	exit(-1);
+}
+
+const char* getMethodName(char method)
+{
+	switch(method)
+	{
+	case 'V': return "BVH";
+	case 'S': return "SSH";
+	case 'D': return "DSH";
+	case 'H': return "hybrid";
+	case 'N': return "no acceleration";
+	}
+	return "unknown";
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2 || argv[argc-1][0] == '-') printUsageAndExit();
+
+	const char* methods = getArgument(argc, argv, "-methods");
+	if(!methods || !methods[0]) methods = "SV";
+
+	const char* arg = getArgument(argc, argv, "-threads");
+	int threads = arg ? atoi(arg) : omp_get_num_procs();
+	if(threads < 1) threads = 1;
+	// the hierarchies allocate their traversal stacks for omp_get_max_threads() threads
+	omp_set_num_threads(threads);
+
+	arg = getArgument(argc, argv, "-repeat");
+	int repeat = arg ? atoi(arg) : 5;
+	if(repeat < 1) repeat = 1;
+
+	const char* nodeTraceFile = getArgument(argc, argv, "-nodeTrace");
+
+	const char* fileName = argv[argc-1];
+	std::vector<Triangle> triangles;
+	RayArena<RayRecord> records;
+	if(!RecordingScene::load(fileName, triangles, records))
+	{
+		std::cout << "could not read ray dump " << fileName << ". it has to be written by a simdtrace of the same build." << endl;
+		return -1;
+	}
+
+	const long count = (long)records.size();
+	std::cout << fileName << ": " << triangles.size() << " triangles, " << count << " ray packets, " << threads << " threads" << endl;
+	if(triangles.empty() || count == 0) return 0;
+
+	// the packets of each kind are replayed separately to report the rays per second of each kind
+	std::vector<long> kindRecords[RecordingScene::KIND_COUNT];
+	for (long i = 0; i < count; ++i)
+	{
+		int kind = records[i].kind;
+		if(kind < 0 || kind >= RecordingScene::KIND_COUNT) kind = RecordingScene::PRIMARY;
+		kindRecords[kind].push_back(i);
+	}
+
+	PackedRay* rays = new PackedRay[count];
+	std::vector<PackedRay*> pointers(count);
+
+	// hit of each lane of the first method. -1 for no hit.
+	std::vector<long> referenceHits(4*count);
+	std::vector<float> referenceDistances(4*count);
+
+	bool differences = false;
+
+	for (size_t m = 0; m < strlen(methods); ++m)
+	{
+		Scene* scene = createScene(methods[m]);
+
+		TimeMeasurement construction;
+		scene->construct(&triangles);
+		std::cout << getMethodName(methods[m]) << ": construction " << construction.getCurrentTime() << " s" << endl;
+
+		double totalTime = 0.0;
+		for (int kind = 0; kind < RecordingScene::KIND_COUNT; ++kind)
+		{
+			const std::vector<long>& indices = kindRecords[kind];
+			const long kindCount = (long)indices.size();
+			if(kindCount == 0) continue;
+
+			for (long i = 0; i < kindCount; ++i)
+			{
+				pointers[i] = &rays[indices[i]];
+			}
+
+			double best = -1.0;
+			for (int r = 0; r < repeat; ++r)
+			{
+				// restore the rays as they were passed to the scene
+				#pragma omp parallel for schedule(static)
+				for (long i = 0; i < kindCount; ++i)
+				{
+					*pointers[i] = records[indices[i]].ray;
+				}
+
+				TimeMeasurement time;
+				#pragma omp parallel for schedule(dynamic, 1)
+				for (long i = 0; i < kindCount; i += REPLAY_BATCH)
+				{
+					IntersectDetails details;
+					scene->intersectPackets(&pointers[i], kindCount - i < REPLAY_BATCH ? kindCount - i : REPLAY_BATCH, details);
+				}
+				double seconds = time.getCurrentTime();
+
+				if(best < 0.0 || seconds < best) best = seconds;
+			}
+
+			totalTime += best;
+			std::cout << "  " << RecordingScene::getKindName(kind) << ": " << 4*kindCount << " rays, "
+				<< best << " s, " << (best > 0.0 ? 4.0*kindCount / best / 1e6 : 0.0) << " Mrays/s" << endl;
+		}
+		std::cout << "  all: " << 4*count << " rays, " << totalTime << " s, " << (totalTime > 0.0 ? 4.0*count / totalTime / 1e6 : 0.0) << " Mrays/s" << endl;
+
+		// compare the hits of the last replay
+		unsigned long recordingDifferences = 0;
+		unsigned long missed[RecordingScene::KIND_COUNT] = { 0 };	// the first method hits, this one does not
+		unsigned long added[RecordingScene::KIND_COUNT] = { 0 };	// this method hits, the first one does not
+		unsigned long moved[RecordingScene::KIND_COUNT] = { 0 };	// both hit at another distance
+		unsigned long ties = 0;	// other triangle at the same distance, e.g. on a shared edge
+		float maxDistanceError = 0.0f;	// relative, of the hits at the same distance
+		for (long i = 0; i < count; ++i)
+		{
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				long hit = rays[i].hit[lane] ? (long)(rays[i].hit[lane] - &triangles[0]) : -1;
+				float distance = rays[i].t[lane];
+
+				if(!sameDistance(distance, records[i].t[lane])) ++recordingDifferences;
+
+				long l = 4*i + lane;
+				if(m == 0)
+				{
+					referenceHits[l] = hit;
+					referenceDistances[l] = distance;
+				}
+				else
+				{
+					int kind = records[i].kind;
+					if(kind < 0 || kind >= RecordingScene::KIND_COUNT) kind = RecordingScene::PRIMARY;
+
+					if(hit < 0 && referenceHits[l] >= 0) ++missed[kind];
+					else if(hit >= 0 && referenceHits[l] < 0) ++added[kind];
+					else if(!sameDistance(distance, referenceDistances[l])) ++moved[kind];
+					else
+					{
+						if(hit != referenceHits[l]) ++ties;
+
+						float reference = referenceDistances[l];
+						if(hit >= 0 && reference == reference)
+						{
+							float error = fabsf(distance - reference) / (fabsf(reference) > 1.0f ? fabsf(reference) : 1.0f);
+							if(error > maxDistanceError) maxDistanceError = error;
+						}
+					}
+				}
+			}
+		}
+
+		unsigned long methodDifferences = 0;
+		for (int kind = 0; kind < RecordingScene::KIND_COUNT; ++kind)
+		{
+			methodDifferences += missed[kind] + added[kind] + moved[kind];
+		}
+
+		std::cout << "  hits: " << recordingDifferences << " rays differ from the recording";
+		if(m > 0) std::cout << ", " << methodDifferences << " rays differ from " << getMethodName(methods[0]) << " (" << ties << " hit another triangle at the same distance)";
+		std::cout << endl;
+		if(m > 0) std::cout << "  distances: max relative difference " << maxDistanceError << " of the same hits" << endl;
+
+		// the kinds tell which traversal path lost the hits
+		for (int kind = 0; kind < RecordingScene::KIND_COUNT; ++kind)
+		{
+			if(missed[kind] + added[kind] + moved[kind] == 0) continue;
+			std::cout << "  " << RecordingScene::getKindName(kind) << ": " << missed[kind] << " missed, " << added[kind] << " hit where "
+				<< getMethodName(methods[0]) << " does not, " << moved[kind] << " hit at another distance" << endl;
+		}
+
+		if(methodDifferences != 0) differences = true;
+
+		if(nodeTraceFile)
+		{
+			// untimed and serial, so the trace is the same for every run
+			NodeAccessTrace trace;
+			std::string traceFile = std::string(nodeTraceFile) + "." + getMethodName(methods[m]);
+			if(!scene->setAccessTrace(&trace))
+			{
+				std::cout << "  node trace: not supported" << endl;
+			}
+			else if(!trace.open(traceFile.c_str()))
+			{
+				std::cout << "  node trace: could not write " << traceFile << endl;
+			}
+			else
+			{
+				for (long i = 0; i < count; ++i)
+				{
+					rays[i] = records[i].ray;
+					IntersectDetails details;
+					PackedRay* ray = &rays[i];
+					scene->intersectPackets(&ray, 1, details);
+				}
+				scene->setAccessTrace(NULL);
+
+				unsigned long packets = trace.getPacketCount();
+				if(trace.close()) std::cout << "  node trace: " << packets << " packets written to " << traceFile << endl;
+				else std::cout << "  node trace: could not write " << traceFile << endl;
+			}
+		}
+
+		delete scene;
+	}
+
+	delete[] rays;
+	return differences ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+# benchmarks the models of "all models.txt" and compares them with testresults/baseline.json.
+# the first run writes the baseline. a regression has to show up in every attempt, so a single noisy run does not fail the gate.
+# usage: sh "regression gate.sh" [tolerance in percent]
+# exit code 2: regression
+
+TOLERANCE=${1:-10}
+ATTEMPTS=3
+BASELINE=testresults/baseline.json
+MODELS=$(cat "all models.txt")
+OPTIONS="-mode=B -methods=SV -resolution=640x480 -threads=1 -warmup=2 -repeat=15"
+
+mkdir -p testresults
+if [ ! -f $BASELINE ]; then
+	./simdtrace $OPTIONS -benchmarkFile=$BASELINE $MODELS
+	exit $?
+fi
+
+attempt=1
+while [ $attempt -le $ATTEMPTS ]; do
+	./simdtrace $OPTIONS -benchmarkFile=testresults/gate.json -baseline=$BASELINE -tolerance=$TOLERANCE $MODELS
+	result=$?
+	if [ $result -ne 2 ]; then exit $result; fi
+	echo "regression in attempt $attempt of $ATTEMPTS"
+	attempt=$((attempt+1))
+done
+exit 2